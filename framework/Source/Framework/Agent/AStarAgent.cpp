@@ -23,15 +23,17 @@ std::set<Method> availableMethods;
 
 const Color pathColor(1.0f, 0.0f, 0.0f, 1.0f);
 
-AStarAgent::AStarAgent(size_t id) : Agent(patherTypeName, id), computingPath(false), movement(Movement::WALK)
+AStarAgent::AStarAgent(size_t id) : Agent(patherTypeName, id), computingPath(false), followingFlow(false), pathHandle(0), cooperating(false), movement(Movement::WALK)
 {
     buffer.settings.heuristic = Heuristic::OCTILE;
     buffer.settings.weight = 1.0f;
+    buffer.settings.weighting = Weighting::STATIC;
     buffer.settings.smoothing = false;
     buffer.settings.rubberBanding = false;
     buffer.settings.singleStep = true;
     buffer.settings.debugColoring = true;
     buffer.settings.method = Method::ASTAR;
+    buffer.settings.incremental = false;
 
     set_heuristic_weight(1.0f);
 
@@ -52,53 +54,84 @@ AStarAgent::AStarAgent(size_t id) : Agent(patherTypeName, id), computingPath(fal
         availableMethods.emplace(Method::GOAL_BOUNDING);
     }
 
+    if (ProjectTwo::implemented_hierarchical() == true)
+    {
+        availableMethods.emplace(Method::HIERARCHICAL);
+    }
+
+    if (ProjectTwo::implemented_theta_star() == true)
+    {
+        availableMethods.emplace(Method::THETA_STAR);
+    }
+
     Callback mapCallback = std::bind(&AStarAgent::on_map_change, this);
     Messenger::listen_for_message(Messages::MAP_CHANGE, mapCallback);
 }
 
+AStarAgent::~AStarAgent()
+{
+    // a background search would otherwise sit finished until the next map change, the pather is already gone
+    // by the time the organizer deletes the agents on shutdown
+    if (pather != nullptr)
+    {
+        pather->cancel_path(pathHandle);
+    }
+
+    // and the other cooperating agents would keep steering around the cells it held
+    leave_cooperation();
+}
+
 void AStarAgent::update(float dt)
 {   
+    // a search running in the background is checked on once a frame, never waited for
+    if (pathHandle != 0)
+    {
+        poll_request();
+    }
+
     switch (movement)
     {
     case Movement::NONE:
-      if (computingPath)
-      {
-        request.newRequest = false;
-
-        process_request();
-      }
-      break;
+        // the path scheduler advances any request in progress
+        break;
     case Movement::WALK:
-        if (computingPath == false)
+        // a flow field hands out one cell at a time, ask for the next once the last is reached
+        if (followingFlow == true && request.path.empty() == true)
         {
-            if (request.path.size() > 0)
+            Vec3 waypoint;
+
+            if (pather->flow_waypoint(get_position(), request.goal, waypoint) == true)
+            {
+                request.path.push_back(waypoint);
+            }
+            else
             {
-                const auto &currPos = get_position();
-                auto delta = (request.path.front() - currPos);
-
-                if (delta.LengthSquared() <= 0.1f)
-                {
-                    request.path.pop_front();
-                }
-                else
-                {
-                    float lenSq = delta.LengthSquared();
-                    float dist = get_movement_speed() * dt / static_cast<float>(terrain->get_map_width());
-                    float distSq = dist * dist;
-                    const auto movement = distSq > lenSq ? delta : dist * delta / std::sqrt(lenSq);
-
-                    set_position(currPos + movement);
-
-                    const float yaw = std::atan2(delta.x, delta.z);
-                    set_yaw(yaw);
-                }
+                followingFlow = false;
             }
         }
-        else
+
+        // a hierarchical path is handed out a piece at a time, so walk whatever has arrived so far
+        if (request.path.empty() == false)
         {
-            request.newRequest = false;
-        
-            process_request();
+            const auto &currPos = get_position();
+            auto delta = (request.path.front() - currPos);
+
+            if (delta.LengthSquared() <= 0.1f)
+            {
+                request.path.advance();
+            }
+            else
+            {
+                float lenSq = delta.LengthSquared();
+                float dist = get_movement_speed() * dt / static_cast<float>(terrain->get_map_width());
+                float distSq = dist * dist;
+                const auto movement = distSq > lenSq ? delta : dist * delta / std::sqrt(lenSq);
+
+                set_position(currPos + movement);
+
+                const float yaw = std::atan2(delta.x, delta.z);
+                set_yaw(yaw);
+            }
         }
         break;
     case Movement::TELEPORT:
@@ -113,6 +146,8 @@ void AStarAgent::path_to(const Vec3 &point, bool timed)
 
     if (terrain->is_valid_grid_position(gridPos.row, gridPos.col) == true)
     {
+        followingFlow = false;
+        leave_cooperation();
         request.path.clear();
         
         request.start = get_position();
@@ -120,18 +155,66 @@ void AStarAgent::path_to(const Vec3 &point, bool timed)
         request.settings = buffer.settings;
         request.newRequest = true;
 
-        if (movement != Movement::TELEPORT)
+        if (movement == Movement::WALK && agents->get_cooperative_pathing() == true)
+        {
+            // the organizer plans the first window on its next timestep
+            agents->get_path_scheduler().cancel(this);
+            pather->cancel_path(pathHandle);
+            pathHandle = 0;
+            computingPath = false;
+            cooperating = true;
+        }
+        else if (movement != Movement::TELEPORT)
         {
             if (timed == true)
             {
                 Messenger::send_message(Messages::PATH_REQUEST_BEGIN);
             }
 
-            process_request();
+            computingPath = true;
+            pather->cancel_path(pathHandle);
+            pathHandle = 0;
+
+            // only the game thread can color or step through a search, or keep an incremental one between requests
+            if (request.settings.singleStep == false && request.settings.debugColoring == false && request.settings.incremental == false)
+            {
+                agents->get_path_scheduler().cancel(this);
+
+                Messenger::send_message(Messages::PATH_REQUEST_TICK_START);
+                pathHandle = pather->submit_path(request);
+                Messenger::send_message(Messages::PATH_REQUEST_TICK_FINISH);
+
+                poll_request();
+            }
+            else
+            {
+                agents->get_path_scheduler().submit(this,
+                    timed == true ? PathScheduler::Priority::INTERACTIVE : PathScheduler::Priority::BACKGROUND);
+            }
         }
     }
 }
 
+void AStarAgent::flow_to(const Vec3 &point)
+{
+    const auto gridPos = terrain->get_grid_position(point);
+
+    if (terrain->is_valid_grid_position(gridPos.row, gridPos.col) == true)
+    {
+        // the field replaces any search still waiting on the scheduler or running in the background
+        agents->get_path_scheduler().cancel(this);
+        pather->cancel_path(pathHandle);
+        pathHandle = 0;
+        leave_cooperation();
+        computingPath = false;
+        followingFlow = true;
+
+        request.path.clear();
+        request.start = get_position();
+        request.goal = point;
+    }
+}
+
 void AStarAgent::next_heuristic_type()
 {
     int next = (static_cast<int>(buffer.settings.heuristic) + 1) % static_cast<int>(Heuristic::NUM_ENTRIES);
@@ -173,6 +256,28 @@ const std::wstring &AStarAgent::get_heuristic_weight_text()
     return heuristicWeightText;
 }
 
+void AStarAgent::next_weighting_type()
+{
+    int next = (static_cast<int>(buffer.settings.weighting) + 1) % static_cast<int>(Weighting::NUM_ENTRIES);
+
+    set_weighting_type(static_cast<Weighting>(next));
+}
+
+Weighting AStarAgent::get_weighting_type()
+{
+    return buffer.settings.weighting;
+}
+
+void AStarAgent::set_weighting_type(Weighting type)
+{
+    buffer.settings.weighting = type;
+}
+
+const std::wstring &AStarAgent::get_weighting_type_text()
+{
+    return get_weighting_wtext(buffer.settings.weighting);
+}
+
 void AStarAgent::toggle_smoothing()
 {
     set_smoothing(!buffer.settings.smoothing);
@@ -283,21 +388,11 @@ void AStarAgent::set_debug_coloring(bool state)
 
 void AStarAgent::draw_debug()
 {
-    if (request.path.size() >= 2)
-    {
-        auto p0 = request.path.begin();
-        auto p1 = p0;
-        ++p1;
-
-        auto &dr = renderer->get_debug_renderer();
-
-        while (p1 != request.path.end())
-        {
-            dr.draw_arrow(*p1, *p0, pathColor);
+    auto &dr = renderer->get_debug_renderer();
 
-            p0 = p1;
-            ++p1;
-        }
+    for (size_t i = 1; i < request.path.size(); ++i)
+    {
+        dr.draw_arrow(request.path[i], request.path[i - 1], pathColor);
     }
 }
 
@@ -311,7 +406,7 @@ void AStarAgent::bulk_set_request_settings(const PathRequest::Settings &settings
     buffer.settings = settings;
 }
 
-void AStarAgent::process_request()
+PathResult AStarAgent::process_request()
 {
     Messenger::send_message(Messages::PATH_REQUEST_TICK_START);
     const auto result = pather->compute_path(request);
@@ -323,15 +418,125 @@ void AStarAgent::process_request()
     case PathResult::IMPOSSIBLE:
         computingPath = false;
         Messenger::send_message(Messages::PATH_REQUEST_END);
+        on_path_finished();
         break;
     case PathResult::PROCESSING:
         computingPath = true;
         break;
     }
+
+    return result;
+}
+
+PathResult AStarAgent::poll_request()
+{
+    const auto result = pather->poll_path(pathHandle, request);
+
+    if (result != PathResult::PROCESSING)
+    {
+        pathHandle = 0;
+        computingPath = false;
+        Messenger::send_message(Messages::PATH_REQUEST_END);
+        on_path_finished();
+    }
+
+    return result;
+}
+
+void AStarAgent::hold_cooperative_cell(ReservationTable &reservations)
+{
+    // until it has planned, an agent holds the cell it's in for the whole window, so the agents planning
+    // before it don't plan through it and leave it boxed in
+    if (needs_cooperative_plan() == true)
+    {
+        const auto cell = terrain->get_grid_position(get_cooperative_cell());
+        const int index = cell.row * terrain->get_map_width() + cell.col;
+
+        for (int step = 0; step < ReservationTable::window; ++step)
+        {
+            reservations.reserve(index, reservations.get_time() + step, get_reservation_owner());
+        }
+    }
 }
 
+void AStarAgent::cooperative_step(ReservationTable &reservations)
+{
+    if (cooperating == false)
+    {
+        return;
+    }
+
+    const unsigned short owner = get_reservation_owner();
+
+    // plan the next window before walking off the end of this one, a parked agent plans every step to keep holding its cell
+    if (needs_cooperative_plan() == true)
+    {
+        reservations.release(owner);
+
+        request.start = get_cooperative_cell();
+        request.path.clear();
+        request.newRequest = true;
+
+        // an agent that can't reach its goal parks where it is, still holding its cell so the others go around
+        if (pather->compute_cooperative_path(request, reservations, owner) == PathResult::IMPOSSIBLE)
+        {
+            request.goal = request.start;
+            pather->compute_cooperative_path(request, reservations, owner);
+        }
+
+        plannedSteps.clear();
+
+        for (const auto &point : request.path)
+        {
+            plannedSteps.push_back(point);
+        }
+    }
+
+    request.path.clear();
+
+    if (plannedSteps.empty() == false)
+    {
+        request.path.push_back(plannedSteps.front());
+        plannedSteps.advance();
+    }
+}
+
+bool AStarAgent::needs_cooperative_plan() const
+{
+    return cooperating == true && plannedSteps.size() < ReservationTable::window / 2;
+}
+
+const Vec3 &AStarAgent::get_cooperative_cell() const
+{
+    // the cell held for the step just starting, even if the agent hasn't quite reached it
+    return request.path.empty() == true ? get_position() : request.path.front();
+}
+
+void AStarAgent::leave_cooperation()
+{
+    if (cooperating == true)
+    {
+        agents->get_reservations().release(get_reservation_owner());
+        cooperating = false;
+        plannedSteps.clear();
+    }
+}
+
+unsigned short AStarAgent::get_reservation_owner() const
+{
+    return static_cast<unsigned short>(get_id() + 1);
+}
+
+void AStarAgent::on_path_finished()
+{}
+
 void AStarAgent::on_map_change()
 {
+    // the pather drops background requests on the same message
+    pathHandle = 0;
     computingPath = false;
+    followingFlow = false;
+    cooperating = false;
+    plannedSteps.clear();
     request.path.clear();
 }
@@ -16,6 +16,8 @@ written consent of DigiPen Institute of Technology is prohibited.
 #include <list>
 #include "misc/PathfindingDetails.hpp"
 
+class ReservationTable;
+
 enum class Movement
 {
     NONE,
@@ -27,14 +29,22 @@ enum class Movement
 
 class AStarAgent : public Agent
 {
+    friend class PathScheduler;
+    friend class AgentOrganizer;
+
 public:
     AStarAgent(size_t id);
+    virtual ~AStarAgent();
 
     virtual void update(float dt) override final;
     static const char *patherTypeName;
 
     virtual void path_to(const Vec3 &point, bool timed = true);
 
+    // walks to the point a cell at a time using the pather's flow field for it, which every
+    // agent heading to the same cell shares, so no search of its own is run
+    void flow_to(const Vec3 &point);
+
     // all the getters and setters needed to hook directly into ui
     void next_heuristic_type();
     Heuristic get_heuristic_type();
@@ -45,6 +55,11 @@ public:
     void set_heuristic_weight(const float &weight);
     const std::wstring &get_heuristic_weight_text();
 
+    void next_weighting_type();
+    Weighting get_weighting_type();
+    void set_weighting_type(Weighting type);
+    const std::wstring &get_weighting_type_text();
+
     void toggle_smoothing();
     bool get_smoothing();
     void set_smoothing(bool state);
@@ -80,11 +95,28 @@ protected:
     PathRequest request;
     PathRequest buffer;
     bool computingPath;
+    bool followingFlow;
+
+    // the background search for request, zero when there isn't one
+    PathHandle pathHandle;
+
+    // with cooperative pathing the organizer plans a window of steps at a time and hands them out one
+    // per timestep, so the agent never gets ahead of the cells it holds
+    bool cooperating;
+    WaypointList plannedSteps;
     Movement movement;
     // we can statically build all other display text but weight
     std::wstring heuristicWeightText;
 
-    void process_request();
+    PathResult process_request();
+    PathResult poll_request();
+    void hold_cooperative_cell(ReservationTable &reservations);
+    void cooperative_step(ReservationTable &reservations);
+    bool needs_cooperative_plan() const;
+    const Vec3 &get_cooperative_cell() const;
+    void leave_cooperation();
+    unsigned short get_reservation_owner() const;
+    virtual void on_path_finished();
 
     void on_map_change();
     
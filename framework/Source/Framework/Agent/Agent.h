@@ -22,6 +22,7 @@ class Agent
     friend class AgentOrganizer;
 public:
     Agent(const char *type, size_t id);
+    virtual ~Agent() = default;
 
 #pragma region Getters
     const Vec3 &get_position() const;
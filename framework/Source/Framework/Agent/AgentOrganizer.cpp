@@ -16,20 +16,22 @@ written consent of DigiPen Institute of Technology is prohibited.
 #include "Projects/ProjectOne.h"
 #include "UI/Elements/Text/UIBehaviorTreeTextField.h"
 
-AgentOrganizer::AgentOrganizer() : cameraAgent(nullptr), bottomTextField(nullptr)
+AgentOrganizer::AgentOrganizer() : cameraAgent(nullptr), cooperativePathing(false), stepTimer(0.0f), bottomTextField(nullptr)
 {}
 
 bool AgentOrganizer::initialize()
 {
     std::cout << "    Initializing Agent System..." << std::endl;
     cameraAgent = new CameraAgent;
-    return true;
+    return pathScheduler.initialize() && reservations.initialize();
 }
 
 void AgentOrganizer::shutdown()
 {
     std::cout << "    Shutting Down Agent System..." << std::endl;
     delete cameraAgent;
+    pathScheduler.shutdown();
+    reservations.shutdown();
 
     for (auto && agent : agentsAll)
     {
@@ -140,6 +142,42 @@ CameraAgent *const AgentOrganizer::get_camera_agent() const
     return cameraAgent;
 }
 
+PathScheduler &AgentOrganizer::get_path_scheduler()
+{
+    return pathScheduler;
+}
+
+void AgentOrganizer::set_cooperative_pathing(bool enabled)
+{
+    if (enabled == false)
+    {
+        for (auto &agent : agentsByType[AStarAgent::patherTypeName])
+        {
+            static_cast<AStarAgent *>(agent)->leave_cooperation();
+        }
+
+        reservations.clear();
+    }
+
+    cooperativePathing = enabled;
+    stepTimer = 0.0f;
+}
+
+void AgentOrganizer::toggle_cooperative_pathing()
+{
+    set_cooperative_pathing(!cooperativePathing);
+}
+
+bool AgentOrganizer::get_cooperative_pathing() const
+{
+    return cooperativePathing;
+}
+
+ReservationTable &AgentOrganizer::get_reservations()
+{
+    return reservations;
+}
+
 void AgentOrganizer::draw() const
 {
     for (const auto & agent : agentsAll)
@@ -158,12 +196,20 @@ void AgentOrganizer::draw_debug() const
 
 void AgentOrganizer::update(float dt)
 {
+    if (cooperativePathing == true)
+    {
+        step_cooperative_agents(dt);
+    }
+
     // avoid ranged for due to iterator invalidation from insertion
     for (size_t i = 0; i < agentsAll.size(); ++i)
     {
         agentsAll[i]->update(dt);
     }
 
+    // path requests made this frame get whatever time the agents left in the budget
+    pathScheduler.update();
+
     if (markedForDeletion.size() > 0)
     {
         std::sort(markedForDeletion.begin(), markedForDeletion.end());
@@ -196,6 +242,12 @@ void AgentOrganizer::update(float dt)
                 }
             #endif
 
+            AStarAgent *pathingAgent = dynamic_cast<AStarAgent *>(agent);
+            if (pathingAgent != nullptr)
+            {
+                pathScheduler.cancel(pathingAgent);
+            }
+
             delete agent;
 
             agentsAll.erase(agentsAll.begin() + *i);
@@ -205,6 +257,51 @@ void AgentOrganizer::update(float dt)
     }
 }
 
+void AgentOrganizer::step_cooperative_agents(float dt)
+{
+    const auto &pathers = agentsByType[AStarAgent::patherTypeName];
+
+    if (pathers.empty() == true)
+    {
+        return;
+    }
+
+    // a timestep lasts as long as the slowest agent takes to cross a cell diagonally, agents walk
+    // speed / map width world units a second, so everyone reaches the cell they hold in time
+    float slowest = std::numeric_limits<float>::max();
+
+    for (const auto &agent : pathers)
+    {
+        slowest = std::min(slowest, agent->get_movement_speed());
+    }
+
+    const float cellSize = (terrain->get_world_position(0, 1) - terrain->get_world_position(0, 0)).Length();
+    const float stepTime = 1.41421356f * cellSize * terrain->get_map_width() / std::max(slowest, 0.001f);
+
+    stepTimer += dt;
+
+    if (stepTimer < stepTime)
+    {
+        return;
+    }
+
+    // never run several steps in one frame after a hitch, the agents couldn't have kept up
+    stepTimer = std::fmod(stepTimer, stepTime);
+
+    reservations.advance();
+
+    for (const auto &agent : pathers)
+    {
+        static_cast<AStarAgent *>(agent)->hold_cooperative_cell(reservations);
+    }
+
+    // earlier agents plan first, later ones route around them
+    for (const auto &agent : pathers)
+    {
+        static_cast<AStarAgent *>(agent)->cooperative_step(reservations);
+    }
+}
+
 void AgentOrganizer::assign_text_field(BehaviorAgent *agent)
 {
     if (freeTextFields.size() > 0)
@@ -17,6 +17,8 @@ written consent of DigiPen Institute of Technology is prohibited.
 #include "AStarAgent.h"
 #include "EnemyAgent.h"
 #include "BehaviorAgent.h"
+#include "PathScheduler.h"
+#include "ReservationTable.h"
 
 enum class BehaviorTreeTypes;
 class UIBehaviorTreeTextField;
@@ -41,12 +43,24 @@ public:
     const std::vector<Agent *> &get_all_agents() const;
     const std::vector<Agent *> &get_all_agents_by_type(const char *type);
     CameraAgent *const get_camera_agent() const;
+    PathScheduler &get_path_scheduler();
+
+    // with cooperative pathing on, every A* agent walking to a point plans around the cells the
+    // others hold over the next few timesteps instead of searching as if it were alone
+    void set_cooperative_pathing(bool enabled);
+    void toggle_cooperative_pathing();
+    bool get_cooperative_pathing() const;
+    ReservationTable &get_reservations();
 
     void draw() const;
     void draw_debug() const;
     void update(float dt);
 private:
     CameraAgent *cameraAgent;
+    PathScheduler pathScheduler;
+    ReservationTable reservations;
+    bool cooperativePathing;
+    float stepTimer;
     std::vector<Agent *> agentsAll;
     std::unordered_map<const char *, std::vector<Agent *>> agentsByType;
     std::unordered_map<Agent::AgentModel, std::vector<Agent*>> agentsByModel;
@@ -57,6 +71,7 @@ private:
     std::vector<UIBehaviorTreeTextField *> freeTextFields;
     UIBehaviorTreeTextField *bottomTextField;
 
+    void step_cooperative_agents(float dt);
     void assign_text_field(BehaviorAgent *agent);
     void unassign_text_field(BehaviorAgent *agent);
 };
\ No newline at end of file
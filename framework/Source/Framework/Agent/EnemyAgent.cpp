@@ -25,12 +25,20 @@ EnemyAgent::EnemyAgent(size_t id) : AStarAgent(id), state(State::IDLE), player(n
 
 void EnemyAgent::path_to(const Vec3 &point)
 {
+    // a chase retargets the same search every time the player changes cells, so let the pather repair it
+    buffer.settings.incremental = state == State::CHASE;
+
     AStarAgent::path_to(point, false);
+}
 
-    // remove the first point
-    if (request.path.size() > 0)
+void EnemyAgent::on_path_finished()
+{
+    // remove the first point, if it's the cell the agent is standing on, a hierarchical path handed over a stretch
+    // at a time has usually been walked past that by the time the search finishes
+    if (request.path.empty() == false &&
+        terrain->get_grid_position(request.path.front()) == terrain->get_grid_position(get_position()))
     {
-        request.path.pop_front();
+        request.path.advance();
     }
 }
 
@@ -97,7 +105,8 @@ bool EnemyAgent::logic_tick()
         set_movement_speed(movementSpeed);
         [[fallthrough]];
     case State::CHASE:
-        if (request.path.size() == 0)
+        // a path still being searched for is empty too, that isn't arriving
+        if (computingPath == false && request.path.empty() == true)
         {
             state = State::IDLE;
         }
@@ -107,7 +116,7 @@ bool EnemyAgent::logic_tick()
     case State::PATROL:
         if (update_timer(reactTimeIdle))
         {
-            if (request.path.size() == 0)
+            if (computingPath == false && request.path.empty() == true)
             {
                 choose_random_goal();
                 update_timer(0.0f);
@@ -54,6 +54,8 @@ private:
     static constexpr float reactTimeIdle = 0.4f;
     static constexpr float reactTimeSeek = 0.1f;
 
+    virtual void on_path_finished() override;
+
     void choose_random_goal();
     bool update_timer(float time);
 };
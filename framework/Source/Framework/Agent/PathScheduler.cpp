@@ -0,0 +1,194 @@
+#include <pch.h>
+#include "PathScheduler.h"
+#include "AStarAgent.h"
+#include "Misc/Stopwatch.h"
+#include "Projects/ProjectTwo.h"
+
+namespace
+{
+    // leaves most of a 60 fps frame for everything else
+    const std::chrono::microseconds defaultBudget(2000);
+}
+
+PathScheduler::PathScheduler() : budget(defaultBudget), savedBudget(defaultBudget), spent(0), latencyCount(0)
+{
+    update_text();
+}
+
+bool PathScheduler::initialize()
+{
+    Callback mapCallback = std::bind(&PathScheduler::on_map_change, this);
+    Messenger::listen_for_message(Messages::MAP_CHANGE, mapCallback);
+
+    // the tests expect every request to finish inside path_to
+    Callback testBeginCallback = std::bind(&PathScheduler::on_test_begin, this);
+    Messenger::listen_for_message(Messages::PATH_TEST_BEGIN, testBeginCallback);
+
+    Callback testEndCallback = std::bind(&PathScheduler::on_test_end, this);
+    Messenger::listen_for_message(Messages::PATH_TEST_END, testEndCallback);
+
+    return true;
+}
+
+void PathScheduler::shutdown()
+{
+    pending.clear();
+}
+
+void PathScheduler::submit(AStarAgent *agent, Priority priority)
+{
+    cancel(agent);
+
+    auto position = pending.begin();
+
+    // a search that has already started can't be set aside, so nothing gets ahead of it
+    if (position != pending.end() && position->agent->request.newRequest == false)
+    {
+        ++position;
+    }
+
+    while (position != pending.end() && position->priority >= priority)
+    {
+        ++position;
+    }
+
+    pending.insert(position, Entry { agent, priority, Stopwatch::now() });
+
+    run();
+}
+
+void PathScheduler::cancel(AStarAgent *agent)
+{
+    for (auto i = pending.begin(); i != pending.end(); ++i)
+    {
+        if (i->agent == agent)
+        {
+            pending.erase(i);
+            break;
+        }
+    }
+}
+
+void PathScheduler::update()
+{
+    run();
+    update_text();
+
+    spent = spent.zero();
+}
+
+void PathScheduler::set_budget(std::chrono::microseconds time)
+{
+    budget = time;
+}
+
+std::chrono::microseconds PathScheduler::get_budget() const
+{
+    return budget;
+}
+
+size_t PathScheduler::get_queue_depth() const
+{
+    return pending.size();
+}
+
+const std::wstring &PathScheduler::get_queue_text()
+{
+    return queueText;
+}
+
+const std::wstring &PathScheduler::get_latency_text()
+{
+    return latencyText;
+}
+
+void PathScheduler::run()
+{
+    while (pending.empty() == false && has_budget() == true)
+    {
+        const Entry &entry = pending.front();
+        AStarAgent *agent = entry.agent;
+
+        if (budget.count() > 0)
+        {
+            pather->set_deadline(Stopwatch::now() + (budget - spent));
+        }
+        else
+        {
+            pather->clear_deadline();
+        }
+
+        const auto sliceStart = Stopwatch::now();
+        const auto result = agent->process_request();
+        const auto sliceEnd = Stopwatch::now();
+
+        pather->clear_deadline();
+        spent += sliceEnd - sliceStart;
+
+        // later slices continue the search instead of starting it over
+        agent->request.newRequest = false;
+
+        // either out of budget or single stepping, which only gets one step per frame
+        if (result == PathResult::PROCESSING)
+        {
+            break;
+        }
+
+        record_latency(std::chrono::duration_cast<std::chrono::microseconds>(sliceEnd - entry.submitted));
+        pending.pop_front();
+    }
+}
+
+bool PathScheduler::has_budget() const
+{
+    return budget.count() == 0 || spent < budget;
+}
+
+void PathScheduler::record_latency(std::chrono::microseconds latency)
+{
+    latencies[latencyCount % latencyWindow] = latency;
+    ++latencyCount;
+}
+
+void PathScheduler::update_text()
+{
+    queueText = std::to_wstring(pending.size());
+
+    const size_t count = std::min(latencyCount, latencyWindow);
+
+    if (count == 0)
+    {
+        latencyText = L"-";
+        return;
+    }
+
+    std::chrono::microseconds total(0);
+    std::chrono::microseconds worst(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        total += latencies[i];
+        worst = std::max(worst, latencies[i]);
+    }
+
+    latencyText = std::to_wstring(total.count() / static_cast<long long>(count)) + L" us avg, " +
+        std::to_wstring(worst.count()) + L" us max";
+}
+
+void PathScheduler::on_map_change()
+{
+    // every agent drops its request on a map change, and the pather's search state goes with the old map
+    pending.clear();
+    latencyCount = 0;
+}
+
+void PathScheduler::on_test_begin()
+{
+    savedBudget = budget;
+    budget = budget.zero();
+}
+
+void PathScheduler::on_test_end()
+{
+    budget = savedBudget;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <deque>
+#include <array>
+#include <string>
+#include <chrono>
+
+class AStarAgent;
+
+// owns every pending path request and runs them against a shared per frame time budget,
+// searches that run out of budget return PROCESSING and pick up where they left off next frame
+class PathScheduler
+{
+public:
+    enum class Priority
+    {
+        BACKGROUND,
+        INTERACTIVE
+    };
+
+    PathScheduler();
+
+    bool initialize();
+    void shutdown();
+
+    // queues the agent's current request, replacing any it already has pending, and starts
+    // working on it immediately if the frame still has budget
+    void submit(AStarAgent *agent, Priority priority);
+    void cancel(AStarAgent *agent);
+
+    // spends whatever is left of this frame's budget, then starts a new frame
+    void update();
+
+    // a budget of zero is unlimited, so every request completes as soon as it's submitted
+    void set_budget(std::chrono::microseconds budget);
+    std::chrono::microseconds get_budget() const;
+
+    size_t get_queue_depth() const;
+    const std::wstring &get_queue_text();
+    const std::wstring &get_latency_text();
+
+private:
+    struct Entry
+    {
+        AStarAgent *agent;
+        Priority priority;
+        std::chrono::high_resolution_clock::time_point submitted;
+    };
+
+    // highest priority first and oldest first within a priority, the pather only holds
+    // one search at a time so the front entry keeps its place until it finishes
+    std::deque<Entry> pending;
+
+    std::chrono::microseconds budget;
+    std::chrono::microseconds savedBudget;
+    std::chrono::nanoseconds spent;
+
+    // submit to completion times of the most recent requests
+    static constexpr size_t latencyWindow = 32;
+    std::array<std::chrono::microseconds, latencyWindow> latencies;
+    size_t latencyCount;
+
+    std::wstring queueText;
+    std::wstring latencyText;
+
+    void run();
+    bool has_budget() const;
+    void record_latency(std::chrono::microseconds latency);
+    void update_text();
+
+    void on_map_change();
+    void on_test_begin();
+    void on_test_end();
+};
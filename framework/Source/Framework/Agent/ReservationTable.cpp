@@ -0,0 +1,139 @@
+#include <pch.h>
+#include "ReservationTable.h"
+
+ReservationTable::ReservationTable() : numCells(0), now(0)
+{}
+
+bool ReservationTable::initialize()
+{
+    Callback mapCallback = std::bind(&ReservationTable::on_map_change, this);
+    Messenger::listen_for_message(Messages::MAP_CHANGE, mapCallback);
+
+    return true;
+}
+
+void ReservationTable::shutdown()
+{
+    slots.clear();
+    held.clear();
+    numCells = 0;
+}
+
+void ReservationTable::resize(int cells)
+{
+    numCells = cells;
+    slots.assign(static_cast<size_t>(numCells * window), nobody);
+    now = 0;
+
+    for (auto &slotsHeld : held)
+    {
+        slotsHeld.clear();
+    }
+}
+
+void ReservationTable::clear()
+{
+    std::fill(slots.begin(), slots.end(), nobody);
+
+    for (auto &slotsHeld : held)
+    {
+        slotsHeld.clear();
+    }
+}
+
+void ReservationTable::advance()
+{
+    // the finished step's slice becomes the one for the new last step of the window
+    const auto slice = slots.begin() + static_cast<ptrdiff_t>(now % window) * numCells;
+    std::fill(slice, slice + numCells, nobody);
+
+    ++now;
+}
+
+unsigned ReservationTable::get_time() const
+{
+    return now;
+}
+
+void ReservationTable::reserve(int cell, unsigned time, unsigned short owner)
+{
+    if (time - now < static_cast<unsigned>(window))
+    {
+        const int index = static_cast<int>(time % window) * numCells + cell;
+
+        if (slots[index] == nobody)
+        {
+            slots[index] = owner;
+
+            if (owner >= held.size())
+            {
+                held.resize(owner + 1);
+            }
+
+            held[owner].push_back(index);
+        }
+    }
+}
+
+void ReservationTable::release(unsigned short owner)
+{
+    if (owner >= held.size())
+    {
+        return;
+    }
+
+    // a slot that has since fallen out of the window was cleared, and may already belong to someone else
+    for (const int index : held[owner])
+    {
+        if (slots[index] == owner)
+        {
+            slots[index] = nobody;
+        }
+    }
+
+    held[owner].clear();
+}
+
+unsigned short ReservationTable::holder(int cell, unsigned time) const
+{
+    if (time - now < static_cast<unsigned>(window))
+    {
+        return slots[(time % window) * numCells + cell];
+    }
+
+    return nobody;
+}
+
+bool ReservationTable::blocks_move(int from, int to, unsigned time, unsigned short owner) const
+{
+    const unsigned short next = holder(to, time + 1);
+
+    if (next != nobody && next != owner)
+    {
+        return true;
+    }
+
+    const unsigned short swapper = holder(to, time);
+
+    return swapper != nobody && swapper != owner && holder(from, time + 1) == swapper;
+}
+
+bool ReservationTable::is_claimed_after(int cell, unsigned time, unsigned short owner) const
+{
+    for (unsigned t = time + 1; t < now + window; ++t)
+    {
+        const unsigned short other = holder(cell, t);
+
+        if (other != nobody && other != owner)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ReservationTable::on_map_change()
+{
+    resize(terrain->get_map_width() * terrain->get_map_height());
+}
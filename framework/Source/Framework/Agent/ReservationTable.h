@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+
+// which agent holds each cell at each of the next window timesteps, so agents planning later can
+// route around the ones that planned first, the steps are kept in a ring of per step slices so
+// moving on to the next step only clears the slice that just fell out of the window
+class ReservationTable
+{
+public:
+    static constexpr int window = 16;
+
+    // owners are agent ids plus one, zero marks a free cell
+    static constexpr unsigned short nobody = 0;
+
+    ReservationTable();
+
+    bool initialize();
+    void shutdown();
+
+    // cells are row * width + col
+    void resize(int numCells);
+    void clear();
+
+    // the current timestep is over, the agents have all reached the cells they held for it
+    void advance();
+    unsigned get_time() const;
+
+    // claims the cell if it's free, times outside the window are ignored
+    void reserve(int cell, unsigned time, unsigned short owner);
+
+    // frees only the slots the owner reserved since it last released
+    void release(unsigned short owner);
+
+    // nobody for times outside the window
+    unsigned short holder(int cell, unsigned time) const;
+
+    // whether someone else holds to at time + 1, or holds to at time and from at time + 1 so the two would swap
+    bool blocks_move(int from, int to, unsigned time, unsigned short owner) const;
+
+    // whether someone else holds the cell at any time after this one in the window
+    bool is_claimed_after(int cell, unsigned time, unsigned short owner) const;
+
+private:
+    // window slices of numCells owners, time t lives in slice t % window
+    std::vector<unsigned short> slots;
+
+    // the slots each owner claimed, indexed by owner, advance doesn't prune them so some may have been freed or reclaimed since
+    std::vector<std::vector<int>> held;
+    int numCells;
+    unsigned now;
+
+    void on_map_change();
+};
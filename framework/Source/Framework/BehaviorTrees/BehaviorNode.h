@@ -38,7 +38,7 @@ class BehaviorNode
 
 public:
     BehaviorNode();
-    ~BehaviorNode();
+    virtual ~BehaviorNode();
 
     // readability status getters
     bool is_ready() const;
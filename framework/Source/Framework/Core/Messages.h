@@ -29,6 +29,7 @@ enum class Messages
     PATH_TEST_END,
 
     MAP_CHANGE,
+    WALL_CHANGE,
 
     NUM_ENTRIES
 };
\ No newline at end of file
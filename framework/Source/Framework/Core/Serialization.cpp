@@ -60,9 +60,9 @@ bool Serialization::initialize()
     while (basePath != rootPath)
     {
         mapsPath = basePath / "Maps";
-        //testsPath = basePath / "Tests";
+        testsPath = basePath / "Tests";
         assetsPath = basePath / "Assets";
-        //outputPath = basePath / "Output";
+        outputPath = basePath / "Output";
         behaviorTreePath = basePath / "Source" / "Student" / "Project_1" / "Trees";
 
         if (fs::exists(mapsPath) &&
@@ -133,8 +133,9 @@ void Serialization::generate_time_stamp(std::stringstream &filename)
 void Serialization::serialize_to(rapidjson::Value &val, const Terrain::MapData &map,
     rapidjson::MemoryPoolAllocator<> &allocator)
 {
-    val.SetArray();
-    val.Reserve(static_cast<rj::SizeType>(map.height), allocator);
+    rj::Value grid;
+    grid.SetArray();
+    grid.Reserve(static_cast<rj::SizeType>(map.height), allocator);
 
     for (const auto & row : map.data)
     {
@@ -150,12 +151,76 @@ void Serialization::serialize_to(rapidjson::Value &val, const Terrain::MapData &
             rowData.PushBack(cellData, allocator);
         }
 
-        val.PushBack(rowData, allocator);
+        grid.PushBack(rowData, allocator);
     }
+
+    bool uniform = true;
+
+    for (const auto & row : map.costs)
+    {
+        uniform = uniform && std::all_of(row.begin(), row.end(), [](float cost) { return cost == 1.0f; });
+    }
+
+    // maps without terrain costs keep the plain grid format
+    if (uniform == true)
+    {
+        val = grid;
+        return;
+    }
+
+    rj::Value costs;
+    costs.SetArray();
+    costs.Reserve(static_cast<rj::SizeType>(map.height), allocator);
+
+    for (const auto & row : map.costs)
+    {
+        rj::Value rowData;
+        rowData.SetArray();
+
+        rowData.Reserve(static_cast<rj::SizeType>(map.width), allocator);
+
+        for (const auto & cell : row)
+        {
+            rj::Value cellData(cell);
+
+            rowData.PushBack(cellData, allocator);
+        }
+
+        costs.PushBack(rowData, allocator);
+    }
+
+    val.SetObject();
+    val.AddMember("Grid", grid, allocator);
+    val.AddMember("Costs", costs, allocator);
 }
 
+// the .txt files in Maps are JSON, either just the grid, an array of booleans per row with true for a wall,
+//     [[false, true, ...], ...]
+// or an object holding the grid and an optional grid of costs with the same dimensions and only positive numbers,
+//     { "Grid": [[false, true, ...], ...], "Costs": [[1.0, 2.5, ...], ...] }
+// a map that breaks either rule is left out
 bool Serialization::deserialize_from(rapidjson::Value &val, Terrain::MapData &map, const std::wstring &id)
 {
+    // a map with terrain costs is an object holding the grid and an optional matching grid of costs
+    if (val.IsObject() == true)
+    {
+        auto gridIter = val.FindMember("Grid");
+        auto costsIter = val.FindMember("Costs");
+
+        if (gridIter == val.MemberEnd())
+        {
+            std::wcout << L"Map " << id << " does not have Grid member" << std::endl;
+            return false;
+        }
+
+        if (deserialize_from(gridIter->value, map, id) == false)
+        {
+            return false;
+        }
+
+        return costsIter == val.MemberEnd() || extract_costs(costsIter->value, map, id);
+    }
+
     // using a single boolean instead of returning on failure to allow for exposing multiple issues
     bool valid = true;
 
@@ -207,6 +272,45 @@ bool Serialization::deserialize_from(rapidjson::Value &val, Terrain::MapData &ma
         }
     }
 
+    // every cell costs the same unless the file says otherwise
+    map.costs.assign(map.height, std::vector<float>(map.width, 1.0f));
+
+    return true;
+}
+
+bool Serialization::extract_costs(rapidjson::Value &val, Terrain::MapData &map, const std::wstring &id)
+{
+    if (val.IsArray() == false || val.Size() != static_cast<rj::SizeType>(map.height))
+    {
+        std::wcout << L"Map " << id << " Costs is not an array with one row per grid row" << std::endl;
+        return false;
+    }
+
+    for (int h = 0; h < map.height; ++h)
+    {
+        const auto &row = val[h];
+
+        if (row.IsArray() == false || row.Size() != static_cast<rj::SizeType>(map.width))
+        {
+            std::wcout << L"Map " << id << " Costs has mismatched number of elements at row " << h <<
+                ", expected " << map.width << std::endl;
+            return false;
+        }
+
+        for (int w = 0; w < map.width; ++w)
+        {
+            // the searches scale their heuristics by the cheapest cost, so zero or negative costs aren't allowed
+            if (row[w].IsNumber() == false || row[w].GetFloat() <= 0.0f)
+            {
+                std::wcout << L"Map " << id << " Costs has an invalid cost at row " << h << ", column " << w <<
+                    ", costs must be positive numbers" << std::endl;
+                return false;
+            }
+
+            map.costs[h][w] = row[w].GetFloat();
+        }
+    }
+
     return true;
 }
 
@@ -554,6 +658,9 @@ void Serialization::serialize_to(rapidjson::Value &val, const PathRequest::Setti
     rj::Value weight;
     weight.SetFloat(settings.weight);
 
+    rj::Value weighting;
+    weighting.SetString(get_weighting_text(settings.weighting), allocator);
+
     rj::Value smoothing;
     smoothing.SetBool(settings.smoothing);
 
@@ -563,6 +670,7 @@ void Serialization::serialize_to(rapidjson::Value &val, const PathRequest::Setti
     val.AddMember("Method", method, allocator);
     val.AddMember("Heuristic", heuristic, allocator);
     val.AddMember("Weight", weight, allocator);
+    val.AddMember("Weighting", weighting, allocator);
     val.AddMember("Smoothing", smoothing, allocator);
     val.AddMember("Rubberbanding", rubberBanding, allocator);
 }
@@ -582,6 +690,7 @@ bool Serialization::deserialize_from(rapidjson::Value &val, PathRequest::Setting
     auto methodIter = val.FindMember("Method");
     auto heuristicIter = val.FindMember("Heuristic");
     auto weightIter = val.FindMember("Weight");
+    auto weightingIter = val.FindMember("Weighting");
     auto smoothingIter = val.FindMember("Smoothing");
     auto rubberIter = val.FindMember("Rubberbanding");
     auto end = val.MemberEnd();
@@ -611,6 +720,21 @@ bool Serialization::deserialize_from(rapidjson::Value &val, PathRequest::Setting
         valid = false;
     }
 
+    // older test files don't have it, they were all written with the weight scaling the whole estimate
+    settings.weighting = Weighting::STATIC;
+
+    if (weightingIter != end)
+    {
+        if (extract_string(weightingIter, end, temp, prefix, L"Weighting", id) == true)
+        {
+            settings.weighting = string_to_weighting(temp);
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
     if (extract_bool(smoothingIter, end, settings.smoothing, prefix, L"Smoothing", id) == false)
     {
         valid = false;
@@ -624,6 +748,7 @@ bool Serialization::deserialize_from(rapidjson::Value &val, PathRequest::Setting
     // default for all tests
     settings.singleStep = false;
     settings.debugColoring = true;
+    settings.incremental = false;
 
     return valid;
 }
@@ -75,6 +75,7 @@ private:
         rapidjson::MemoryPoolAllocator<> &allocator);
     static bool deserialize_from(rapidjson::Value &val, Terrain::MapData &map,
         const std::wstring &id);
+    static bool extract_costs(rapidjson::Value &val, Terrain::MapData &map, const std::wstring &id);
 
     static void serialize_to(rapidjson::Value &val, const PathingTestCase &test,
         rapidjson::MemoryPoolAllocator<> &allocator);
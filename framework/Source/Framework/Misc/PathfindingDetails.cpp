@@ -16,13 +16,14 @@ written consent of DigiPen Institute of Technology is prohibited.
 
 namespace
 {
-    const std::string heuristicText[] = { "Octile", "Chebyshev", "Inconsistent", "Manhattan", "Euclidean", "Invalid" };
-    const std::string methodText[] = { "A*", "Floyd-Warshall", "JPS+", "Goal Bounding", "Invalid" };
+    const std::string heuristicText[] = { "Octile", "Chebyshev", "Inconsistent", "Manhattan", "Euclidean", "Landmark", "Invalid" };
+    const std::string methodText[] = { "A*", "Floyd-Warshall", "JPS+", "Goal Bounding", "HPA*", "Theta*", "Invalid" };
+    const std::string weightingText[] = { "Static", "Dynamic", "Focal", "Invalid" };
 }
 
 const std::wstring &get_heuristic_wtext(Heuristic heuristic)
 {
-    static const std::wstring text[] = { L"Octile", L"Chebyshev", L"Inconsistent", L"Manhattan", L"Euclidean", L"Invalid" };
+    static const std::wstring text[] = { L"Octile", L"Chebyshev", L"Inconsistent", L"Manhattan", L"Euclidean", L"Landmark", L"Invalid" };
 
     return text[static_cast<size_t>(heuristic)];
 }
@@ -47,7 +48,7 @@ Heuristic string_to_heuristic(const std::string &string)
 
 const std::wstring &get_method_wtext(Method method)
 {
-    static const std::wstring text[] = { L"A*", L"Floyd-Warshall", L"JPS+", L"Goal Bounding", L"Invalid" };
+    static const std::wstring text[] = { L"A*", L"Floyd-Warshall", L"JPS+", L"Goal Bounding", L"HPA*", L"Theta*", L"Invalid" };
 
     return text[static_cast<size_t>(method)];
 }
@@ -69,3 +70,28 @@ Method string_to_method(const std::string &string)
 
     return Method::NUM_ENTRIES;
 }
+
+const std::wstring &get_weighting_wtext(Weighting weighting)
+{
+    static const std::wstring text[] = { L"Static", L"Dynamic", L"Focal", L"Invalid" };
+
+    return text[static_cast<size_t>(weighting)];
+}
+
+const std::string &get_weighting_text(Weighting weighting)
+{
+    return weightingText[static_cast<size_t>(weighting)];
+}
+
+Weighting string_to_weighting(const std::string &string)
+{
+    for (size_t i = 0; i < static_cast<size_t>(Weighting::NUM_ENTRIES); ++i)
+    {
+        if (weightingText[i] == string)
+        {
+            return static_cast<Weighting>(i);
+        }
+    }
+
+    return Weighting::NUM_ENTRIES;
+}
@@ -13,9 +13,80 @@ written consent of DigiPen Institute of Technology is prohibited.
 
 #pragma once
 #include "Misc/NiceTypes.h"
-#include <list>
+#include <vector>
 
-using WaypointList = std::list<Vec3>;
+// a path's points stored back to back, clearing keeps the storage so later paths reuse it, and walking
+// the path advances a cursor past the points already reached instead of erasing them from the front
+class WaypointList
+{
+public:
+    using const_iterator = std::vector<Vec3>::const_iterator;
+
+    WaypointList() : cursor(0)
+    {}
+
+    void push_back(const Vec3 &point)
+    {
+        points.push_back(point);
+    }
+
+    // the next point is reached, move on to the one after it
+    void advance()
+    {
+        ++cursor;
+    }
+
+    void clear()
+    {
+        points.clear();
+        cursor = 0;
+    }
+
+    bool empty() const
+    {
+        return cursor == points.size();
+    }
+
+    // only the points not yet reached
+    size_t size() const
+    {
+        return points.size() - cursor;
+    }
+
+    size_t capacity() const
+    {
+        return points.capacity();
+    }
+
+    const Vec3 &front() const
+    {
+        return points[cursor];
+    }
+
+    const Vec3 &back() const
+    {
+        return points.back();
+    }
+
+    const Vec3 &operator[](size_t index) const
+    {
+        return points[cursor + index];
+    }
+
+    const_iterator begin() const
+    {
+        return points.begin() + cursor;
+    }
+
+    const_iterator end() const
+    {
+        return points.end();
+    }
+
+private:
+    std::vector<Vec3> points;
+    size_t cursor;
+};
 
 enum class Heuristic
 {
@@ -24,6 +95,7 @@ enum class Heuristic
     INCONSISTENT,
     MANHATTAN,
     EUCLIDEAN,
+    LANDMARK,
 
     NUM_ENTRIES
 };
@@ -38,6 +110,8 @@ enum class Method
     FLOYD_WARSHALL,
     JPS_PLUS,
     GOAL_BOUNDING,
+    HIERARCHICAL,
+    THETA_STAR,
 
     NUM_ENTRIES
 };
@@ -46,6 +120,27 @@ const std::wstring &get_method_wtext(Method method);
 const std::string &get_method_text(Method method);
 Method string_to_method(const std::string &string);
 
+// how the weight trades path cost for fewer expansions, every mode keeps paths within weight times the optimal
+// cost as long as the heuristic never overestimates
+enum class Weighting
+{
+    // the whole estimate is scaled by the weight
+    STATIC,
+
+    // the estimate is scaled by the full weight at the start, easing to none as the nodes near the goal
+    DYNAMIC,
+
+    // A* ordering, except the next node is the one estimated closest to the goal out of every open node
+    // costing at most weight times the cheapest
+    FOCAL,
+
+    NUM_ENTRIES
+};
+
+const std::wstring &get_weighting_wtext(Weighting weighting);
+const std::string &get_weighting_text(Weighting weighting);
+Weighting string_to_weighting(const std::string &string);
+
 struct PathRequest
 {
     Vec3 start;
@@ -57,10 +152,14 @@ struct PathRequest
         Method method;
         Heuristic heuristic;
         float weight;
+        Weighting weighting;
         bool smoothing;
         bool rubberBanding;
         bool singleStep;
         bool debugColoring;
+
+        // keep the search between requests and repair it as the goal moves, instead of starting over
+        bool incremental;
     } settings;
 
     bool newRequest;
@@ -71,4 +170,7 @@ enum class PathResult
     PROCESSING,
     COMPLETE,
     IMPOSSIBLE
-};
\ No newline at end of file
+};
+
+// names a request being searched in the background, zero names none
+using PathHandle = unsigned;
\ No newline at end of file
@@ -289,6 +289,10 @@ void ProjectThree::build_ui()
     auto hideButton = ui->create_toggle_button(UIAnchor::BOTTOM, dualButton,
         10, hideCB, L"Hide and Seek", hideGet);
 
+    // run the terrain analysis benchmarks into the output directory, the window stalls until they finish
+    Callback benchmarkCB = std::bind(&AnalysisTester::execute_benchmarks, &tester);
+    auto benchmarkButton = ui->create_button(UIAnchor::BOTTOM, hideButton, 10, benchmarkCB, L"Benchmarks");
+
     // add some text on the left side for displaying fps
     TextGetter fpsGetter = std::bind(&Engine::get_fps_text, engine.get());
     auto fpsText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 32, L"FPS:", fpsGetter);
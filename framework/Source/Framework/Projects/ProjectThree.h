@@ -14,6 +14,7 @@ written consent of DigiPen Institute of Technology is prohibited.
 #pragma once
 #include "Project.h"
 #include "../Student/Project_2/P2_Pathfinding.h"
+#include "Testing/AnalysisTester.h"
 #include <memory>
 
 class ProjectThree final : public Project
@@ -37,6 +38,7 @@ public:
 private:
     AStarAgent *player;
     EnemyAgent *enemy;
+    AnalysisTester tester;
 
     std::wstring propagationDecayText;
     std::wstring propagationGrowthText;
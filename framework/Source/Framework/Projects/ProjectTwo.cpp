@@ -68,7 +68,7 @@ bool ProjectTwo::initialize()
 bool ProjectTwo::finalize()
 {
     agent = agents->create_pathing_agent();
-    //tester.set_agent(agent);    
+    tester.set_agent(agent);
 
     // initialize the position text
     grid_pos_to_text(GridPos { -1, -1 }, startPosText);
@@ -172,10 +172,32 @@ void ProjectTwo::build_ui()
     Callback toggleVisCB = std::bind(&Terrain::toggle_graph, terrain.get());
     auto visButton = ui->create_button(UIAnchor::TOP_RIGHT, -90, 64, toggleVisCB, L"Visibility Graph");
 
+    // have every agent plan around the cells the others hold
+    Callback cooperativeCB = std::bind(&AgentOrganizer::toggle_cooperative_pathing, agents.get());
+    auto cooperativeButton = ui->create_button(UIAnchor::TOP_RIGHT, -90, 96, cooperativeCB, L"Cooperative");
+
+    // run every pathfinding benchmark into the output directory, the window stalls until they finish
+    Callback benchmarkCB = std::bind(&PathTester::execute_benchmarks, &tester);
+    auto benchmarkButton = ui->create_button(UIAnchor::TOP_RIGHT, -90, 128, benchmarkCB, L"Benchmarks");
+
     // add some text on the left side for displaying fps
     TextGetter fpsGetter = std::bind(&Engine::get_fps_text, engine.get());
     auto fpsText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 32, L"FPS:", fpsGetter);
 
+    // path scheduler stats, below the visibility graph readout
+    auto &scheduler = agents->get_path_scheduler();
+    TextGetter queueGetter = std::bind(&PathScheduler::get_queue_text, &scheduler);
+    auto queueText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 160, L"Path Queue:", queueGetter);
+
+    TextGetter latencyGetter = std::bind(&PathScheduler::get_latency_text, &scheduler);
+    auto latencyText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 192, L"Path Latency:", latencyGetter);
+
+    TextGetter cacheGetter = std::bind(&PathCache::get_stats_text, &pather->get_path_cache());
+    auto cacheText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 224, L"Path Cache:", cacheGetter);
+
+    TextGetter flowGetter = std::bind(&FlowFieldCache::get_stats_text, &pather->get_flow_fields());
+    auto flowText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 256, L"Flow Fields:", flowGetter);
+
     // add a text field at the top for the project
     auto projectBanner = ui->create_banner_text_field(UIAnchor::TOP, 0, 32,
         UIAnchor::CENTER, L"Final Project");
@@ -191,6 +213,12 @@ void ProjectTwo::link_input()
     Callback leftMouseCB = std::bind(&ProjectTwo::on_left_mouse_click, this);
     InputHandler::notify_when_mouse_pressed(MouseButtons::LEFT, leftMouseCB);
 
+    Callback rightMouseCB = std::bind(&ProjectTwo::on_right_mouse_click, this);
+    InputHandler::notify_when_mouse_pressed(MouseButtons::RIGHT, rightMouseCB);
+
+    Callback middleMouseCB = std::bind(&ProjectTwo::on_middle_mouse_click, this);
+    InputHandler::notify_when_mouse_pressed(MouseButtons::MIDDLE, middleMouseCB);
+
     Callback f1CB = std::bind(&ProjectTwo::on_f1, this);
     InputHandler::notify_when_key_pressed(KBKeys::F1, f1CB);
 
@@ -226,6 +254,45 @@ void ProjectTwo::on_left_mouse_click()
     
 }
 
+void ProjectTwo::on_right_mouse_click()
+{
+    const auto &mousePos = InputHandler::get_mouse_position();
+    const auto worldPos = renderer->screen_to_world(mousePos.x, mousePos.y, terrain->get_terrain_plane());
+
+    if (worldPos.second == true)
+    {
+        const auto gridPos = terrain->get_grid_position(worldPos.first);
+
+        if (terrain->is_valid_grid_position(gridPos) && !terrain->is_wall(gridPos))
+        {
+            const auto agentPos = terrain->get_grid_position(agent->get_position());
+
+            grid_pos_to_text(gridPos, goalPosText);
+            grid_pos_to_text(agentPos, startPosText);
+
+            // follow the shared flow field to the position instead of searching
+            agent->flow_to(worldPos.first);
+        }
+    }
+}
+
+void ProjectTwo::on_middle_mouse_click()
+{
+    const auto &mousePos = InputHandler::get_mouse_position();
+    const auto worldPos = renderer->screen_to_world(mousePos.x, mousePos.y, terrain->get_terrain_plane());
+
+    if (worldPos.second == true)
+    {
+        const auto gridPos = terrain->get_grid_position(worldPos.first);
+
+        // leave the agent's own cell alone so it's never stuck inside a wall
+        if (terrain->is_valid_grid_position(gridPos) && gridPos != terrain->get_grid_position(agent->get_position()))
+        {
+            terrain->toggle_wall(gridPos.row, gridPos.col);
+        }
+    }
+}
+
 void ProjectTwo::on_f1()
 {
     engine->change_projects(Project::Type::ONE);
@@ -34,6 +34,8 @@ public:
     static bool implemented_floyd_warshall();
     static bool implemented_goal_bounding();
     static bool implemented_jps_plus();
+    static bool implemented_hierarchical();
+    static bool implemented_theta_star();
 
 private:
     AStarAgent *agent;
@@ -44,6 +46,8 @@ private:
     void link_input();
 
     void on_left_mouse_click();
+    void on_right_mouse_click();
+    void on_middle_mouse_click();
     void on_f1();
     void on_f3();
 
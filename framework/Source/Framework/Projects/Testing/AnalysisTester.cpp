@@ -0,0 +1,355 @@
+#include <pch.h>
+#include "AnalysisTester.h"
+#include "Benchmark.h"
+#include "Terrain/TerrainAnalysis.h"
+#include "Terrain/MapMath.h"
+#include "../Student/Project_3/P3_Occupancy.h"
+#include <random>
+
+namespace
+{
+    // is_clear_path as it was before it traced the cells a line crosses, kept to measure against, it tests the four
+    // edges of every wall in the line's bounding box with line_intersect, which is true when the segments cross,
+    // that is when the wall blocks the line, so the answer is the opposite of any of them
+    bool reference_clear_path(int row0, int col0, int row1, int col1)
+    {
+        const int minRow = std::min(row0, row1);
+        const int maxRow = std::max(row0, row1);
+        const int minCol = std::min(col0, col1);
+        const int maxCol = std::max(col0, col1);
+
+        const Vec2 start(row0 / 20.0f, col0 / 20.0f);
+        const Vec2 end(row1 / 20.0f, col1 / 20.0f);
+
+        const float offset = 1.0f / 40.0f + FLT_EPSILON;
+
+        for (int row = minRow; row <= maxRow; ++row)
+        {
+            for (int col = minCol; col <= maxCol; ++col)
+            {
+                if (terrain->is_wall(row, col) == true)
+                {
+                    const Vec2 tl(row / 20.0f - offset, col / 20.0f - offset);
+                    const Vec2 tr(row / 20.0f + offset, col / 20.0f - offset);
+                    const Vec2 bl(row / 20.0f - offset, col / 20.0f + offset);
+                    const Vec2 br(row / 20.0f + offset, col / 20.0f + offset);
+
+                    if (line_intersect(start, end, tl, tr) || line_intersect(start, end, tl, bl) ||
+                        line_intersect(start, end, bl, br) || line_intersect(start, end, tr, br))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // whether the line between two cell centers passes exactly through a corner where four cells meet with a wall
+    // among them, the one place the traced and the reference answers are expected to differ
+    bool crosses_walled_corner(int row0, int col0, int row1, int col1)
+    {
+        const int rowDelta = row1 - row0;
+        const int colDelta = col1 - col0;
+
+        // in half cells the centers are odd, so a corner is a point on the line with both coordinates even
+        for (int step = 0; rowDelta != 0 && colDelta != 0 && step < std::abs(rowDelta); ++step)
+        {
+            const int along = colDelta * (2 * step + 1);
+
+            if (along % std::abs(rowDelta) != 0)
+            {
+                continue;
+            }
+
+            const int halfCol = 2 * col0 + 1 + along / std::abs(rowDelta);
+
+            if (halfCol % 2 != 0)
+            {
+                continue;
+            }
+
+            const int row = (2 * row0 + 1 + (rowDelta > 0 ? 1 : -1) * (2 * step + 1)) / 2;
+            const int col = halfCol / 2;
+
+            for (const auto &[r, c] : { std::make_pair(row - 1, col - 1), std::make_pair(row - 1, col),
+                std::make_pair(row, col - 1), std::make_pair(row, col) })
+            {
+                if (terrain->is_valid_grid_position(r, c) == true && terrain->is_wall(r, c) == true)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+}
+
+void AnalysisTester::execute_benchmarks()
+{
+    std::cout << "Running terrain analysis benchmarks, results are written to " << Serialization::outputPath << std::endl;
+
+    // every benchmark picks the maps it needs, so put the user back on theirs afterwards
+    const unsigned map = terrain->get_map_index();
+
+    execute_line_of_sight_benchmark();
+    execute_propagation_benchmark();
+
+    terrain->goto_map(map);
+}
+
+void AnalysisTester::execute_line_of_sight_benchmark()
+{
+    // every ordered pair of cells on every map, through the old bounding box test, one line at a time,
+    // and then a cell's lines all at once
+    struct Row
+    {
+        size_t map;
+        int cells;
+        size_t visible;
+        size_t batchedDisagreements;
+        size_t referenceDisagreements;
+        size_t referenceCorners;
+        size_t referenceOneSided;
+        std::vector<BenchmarkSeries> series;
+    };
+
+    struct Disagreement
+    {
+        size_t map;
+        GridPos from;
+        GridPos to;
+        bool traced;
+        bool reference;
+        bool referenceReversed;
+        bool corner;
+    };
+
+    // enough of them to see the pattern without burying the table
+    const size_t maxListed = 50;
+
+    std::vector<Row> rows;
+    std::vector<Disagreement> listed;
+
+    for (size_t map = 0; map < terrain->num_maps(); ++map)
+    {
+        terrain->goto_map(static_cast<unsigned>(map));
+
+        const int width = terrain->get_map_width();
+        const int numCells = width * terrain->get_map_height();
+
+        std::vector<GridPos> cells;
+        cells.reserve(numCells);
+
+        for (int cell = 0; cell < numCells; ++cell)
+        {
+            cells.push_back(GridPos { cell / width, cell % width });
+        }
+
+        std::vector<unsigned char> reference(static_cast<size_t>(numCells) * numCells);
+        std::vector<unsigned char> single(reference.size());
+        std::vector<unsigned char> batched(reference.size());
+
+        const auto grid = terrain->get_snapshot();
+
+        const auto trace_each = [&](unsigned char *clear, bool (*trace)(int, int, int, int))
+        {
+            for (int from = 0; from < numCells; ++from)
+            {
+                for (int to = 0; to < numCells; ++to)
+                {
+                    clear[from * numCells + to] = trace(cells[from].row, cells[from].col, cells[to].row, cells[to].col) ? 1 : 0;
+                }
+            }
+        };
+
+        const auto trace_batched = [&]()
+        {
+            for (int from = 0; from < numCells; ++from)
+            {
+                trace_clear_paths(grid->walls.data(), width, cells[from].row, cells[from].col, cells.data(), numCells, &batched[from * numCells]);
+            }
+        };
+
+        Row row { map, numCells, 0, 0, 0, 0, 0, time_passes(1,
+        {
+            { "Old us", [&]() { trace_each(reference.data(), reference_clear_path); } },
+            { "Single us", [&]() { trace_each(single.data(), is_clear_path); } },
+            { "Batched us", trace_batched }
+        }) };
+
+        for (int from = 0; from < numCells; ++from)
+        {
+            for (int to = 0; to < numCells; ++to)
+            {
+                const size_t i = static_cast<size_t>(from) * numCells + to;
+
+                row.visible += single[i];
+                row.batchedDisagreements += (single[i] != batched[i]);
+
+                if (single[i] == reference[i])
+                {
+                    continue;
+                }
+
+                const bool corner = crosses_walled_corner(cells[from].row, cells[from].col, cells[to].row, cells[to].col);
+                const bool reversed = reference[static_cast<size_t>(to) * numCells + from] != 0;
+
+                ++row.referenceDisagreements;
+                row.referenceCorners += corner ? 1 : 0;
+                row.referenceOneSided += reversed != (reference[i] != 0) ? 1 : 0;
+
+                if (listed.size() < maxListed)
+                {
+                    listed.push_back(Disagreement { map, cells[from], cells[to], single[i] != 0, reference[i] != 0, reversed, corner });
+                }
+            }
+        }
+
+        rows.push_back(std::move(row));
+    }
+
+    BenchmarkReport report("LineOfSightBenchmark");
+    report.line("Old is the bounding box test is_clear_path used before it traced cells, Disagree compares the batched ",
+        "trace with the single one, Old disagree compares the old test with it");
+    report.line("Corner counts the old disagreements on lines through a corner where four cells meet with a wall among ",
+        "them, One-sided counts those where the old test answered the line and its reverse differently");
+    report.line();
+
+    const std::streamsize width = 14;
+
+    report.columns({ { "Map", width / 2 }, { "Cells", width }, { "Clear", width }, { "Disagree", width },
+        { "Old disagree", width }, { "Corner", width }, { "One-sided", width }, { "Old us", width },
+        { "Single us", width }, { "Batched us", 0 } });
+
+    for (const auto &row : rows)
+    {
+        report.row(row.map, row.cells, row.visible, row.batchedDisagreements, row.referenceDisagreements, row.referenceCorners,
+            row.referenceOneSided, row.series[0].total(), row.series[1].total(), row.series[2].total());
+    }
+
+    report.line();
+    report.line("The first ", listed.size(), " lines the old test disagrees on, 1 is clear");
+    report.columns({ { "Map", width / 2 }, { "From", width }, { "To", width }, { "Traced", width }, { "Old", width },
+        { "Old reversed", width }, { "Corner", 0 } });
+
+    for (const auto &line : listed)
+    {
+        report.row(line.map, std::to_string(line.from.row) + ", " + std::to_string(line.from.col),
+            std::to_string(line.to.row) + ", " + std::to_string(line.to.col), line.traced, line.reference,
+            line.referenceReversed, line.corner);
+    }
+}
+
+void AnalysisTester::execute_propagation_benchmark()
+{
+    // the occupancy stencil on a map sized grid and on much larger ones, each kernel checked against the scalar one
+    struct Row
+    {
+        int size;
+        bool dual;
+        const char *kernel;
+        int iterations;
+        std::chrono::microseconds time;
+        float difference;
+    };
+
+    const int sizes[] = { 40, 256, 1024 };
+    const std::pair<OccupancyKernel, const char *> kernels[] = { { OccupancyKernel::SCALAR, "Scalar" },
+        { OccupancyKernel::SSE2, "SSE2" }, { OccupancyKernel::AVX2, "AVX2" } };
+
+    // about the same number of cell updates at every size
+    const int cellUpdates = 1 << 26;
+    const float decay = 0.1f;
+    const float growth = 0.2f;
+
+    std::vector<Row> rows;
+    std::mt19937 generator(380);
+
+    for (const int size : sizes)
+    {
+        std::bernoulli_distribution wallChance(0.25);
+        std::vector<bool> walls(static_cast<size_t>(size) * size);
+
+        for (size_t cell = 0; cell < walls.size(); ++cell)
+        {
+            walls[cell] = wallChance(generator);
+        }
+
+        OccupancyGrid grid;
+        grid.build(size, size, [&](int row, int col) { return walls[row * size + col]; });
+
+        const int iterations = std::max(1, cellUpdates / (size * size));
+
+        for (const bool dual : { false, true })
+        {
+            std::uniform_real_distribution<float> valueRange(dual == true ? -1.0f : 0.0f, 1.0f);
+            std::vector<float> initial(walls.size());
+
+            for (auto &value : initial)
+            {
+                value = valueRange(generator);
+            }
+
+            std::vector<float> reference;
+
+            for (const auto &kernel : kernels)
+            {
+                if (kernel.first == OccupancyKernel::AVX2 && OccupancyGrid::has_avx2() == false)
+                {
+                    continue;
+                }
+
+                for (int row = 0; row < size; ++row)
+                {
+                    std::copy_n(&initial[row * size], size, grid.get_row(row));
+                }
+
+                const auto series = time_passes(1, { { kernel.second, [&]()
+                {
+                    for (int i = 0; i < iterations; ++i)
+                    {
+                        grid.propagate(decay, growth, dual, kernel.first);
+                    }
+                } } });
+
+                std::vector<float> result(initial.size());
+
+                for (int row = 0; row < size; ++row)
+                {
+                    std::copy_n(grid.get_row(row), size, &result[row * size]);
+                }
+
+                if (reference.empty() == true)
+                {
+                    reference = result;
+                }
+
+                float difference = 0.0f;
+
+                for (size_t cell = 0; cell < result.size(); ++cell)
+                {
+                    difference = std::max(difference, std::abs(result[cell] - reference[cell]));
+                }
+
+                rows.push_back(Row { size, dual, kernel.second, iterations, series[0].passes[0], difference });
+            }
+        }
+    }
+
+    BenchmarkReport report("PropagationBenchmark");
+
+    const std::streamsize width = 14;
+
+    report.columns({ { "Size", width / 2 }, { "Dual", width / 2 }, { "Kernel", width }, { "Iterations", width },
+        { "Time us", width }, { "ns/cell", width }, { "Max difference", 0 } });
+
+    for (const auto &row : rows)
+    {
+        const double perCell = row.time.count() * 1000.0 / (static_cast<double>(row.iterations) * row.size * row.size);
+
+        report.row(row.size, row.dual, row.kernel, row.iterations, row.time.count(), perCell, row.difference);
+    }
+}
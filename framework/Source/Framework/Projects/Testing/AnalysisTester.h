@@ -0,0 +1,10 @@
+#pragma once
+
+// the terrain analysis benchmarks, each writes its results to the output directory
+class AnalysisTester
+{
+public:
+    void execute_benchmarks();
+    void execute_line_of_sight_benchmark();
+    void execute_propagation_benchmark();
+};
@@ -0,0 +1,127 @@
+#include <pch.h>
+#include "Benchmark.h"
+#include "Core/Serialization.h"
+#include "Misc/Stopwatch.h"
+#include <sstream>
+
+namespace
+{
+    const std::streamsize passWidth = 10;
+}
+
+BenchmarkSeries::Time::rep BenchmarkSeries::fastest() const
+{
+    return passes.empty() == true ? 0 : std::min_element(passes.begin(), passes.end())->count();
+}
+
+BenchmarkSeries::Time::rep BenchmarkSeries::total() const
+{
+    Time::rep sum = 0;
+
+    for (const auto &pass : passes)
+    {
+        sum += pass.count();
+    }
+
+    return sum;
+}
+
+BenchmarkSeries::Time::rep BenchmarkSeries::average() const
+{
+    return total() / std::max<Time::rep>(static_cast<Time::rep>(passes.size()), 1);
+}
+
+std::vector<BenchmarkSeries> time_passes(size_t numPasses,
+    const std::vector<std::pair<std::string, std::function<void()>>> &contenders)
+{
+    std::vector<BenchmarkSeries> series(contenders.size());
+
+    for (size_t c = 0; c < contenders.size(); ++c)
+    {
+        series[c].name = contenders[c].first;
+        series[c].passes.reserve(numPasses);
+    }
+
+    Stopwatch timer;
+
+    for (size_t i = 0; i < numPasses; ++i)
+    {
+        for (size_t c = 0; c < contenders.size(); ++c)
+        {
+            timer.start();
+            contenders[c].second();
+            timer.stop();
+
+            series[c].passes.push_back(timer.microseconds());
+        }
+    }
+
+    return series;
+}
+
+BenchmarkReport::BenchmarkReport(const std::string &title)
+{
+    std::stringstream filename;
+    filename << title << "_";
+    Serialization::generate_time_stamp(filename);
+    filename << ".txt";
+
+    // a fresh checkout has no output directory until something is written to it
+    std::error_code error;
+    std::filesystem::create_directories(Serialization::outputPath, error);
+
+    file.open(Serialization::outputPath / filename.str());
+    file << std::left << std::setfill(' ');
+}
+
+void BenchmarkReport::summary(const BenchmarkSeries &series)
+{
+    line(series.name, " fastest: ", series.fastest(), " microseconds");
+    line(series.name, " average: ", series.average(), " microseconds");
+}
+
+void BenchmarkReport::speedup(const BenchmarkSeries &slower, const BenchmarkSeries &faster)
+{
+    line("Speedup: ", static_cast<double>(slower.total()) / std::max<BenchmarkSeries::Time::rep>(faster.total(), 1), "x");
+}
+
+void BenchmarkReport::columns(const std::vector<std::pair<std::string, std::streamsize>> &headers)
+{
+    widths.clear();
+
+    for (const auto &[header, width] : headers)
+    {
+        file << std::setw(width) << header;
+        widths.push_back(width);
+    }
+
+    file << std::endl;
+}
+
+void BenchmarkReport::pass_table(const std::vector<BenchmarkSeries> &series)
+{
+    std::vector<std::pair<std::string, std::streamsize>> headers { { "Test #", passWidth } };
+
+    for (const auto &s : series)
+    {
+        headers.emplace_back(s.name, passWidth * 2);
+    }
+
+    // nothing follows the last column to pad against
+    headers.back().second = 0;
+    columns(headers);
+
+    const size_t numPasses = series.empty() == true ? 0 : series.front().passes.size();
+
+    for (size_t i = 0; i < numPasses; ++i)
+    {
+        file << std::setw(widths[0]) << std::to_string(i + 1) + ":";
+
+        for (size_t s = 0; s < series.size(); ++s)
+        {
+            file << std::setw(widths[s + 1]) << series[s].passes[i].count();
+        }
+
+        file << std::endl;
+    }
+}
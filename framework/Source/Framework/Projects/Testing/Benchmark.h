@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// the time every pass of one contender took
+struct BenchmarkSeries
+{
+    using Time = std::chrono::microseconds;
+
+    std::string name;
+    std::vector<Time> passes;
+
+    Time::rep fastest() const;
+    Time::rep total() const;
+    Time::rep average() const;
+};
+
+// runs every contender once per pass, one after the other, so each of them sees the others' leftovers alike
+std::vector<BenchmarkSeries> time_passes(size_t numPasses,
+    const std::vector<std::pair<std::string, std::function<void()>>> &contenders);
+
+// a report in the output directory, named after the benchmark and stamped with the time it was written
+class BenchmarkReport
+{
+public:
+    explicit BenchmarkReport(const std::string &title);
+
+    // writes its arguments on one line, no arguments leaves a blank one
+    template <typename ...Values>
+    void line(const Values &...values);
+
+    void summary(const BenchmarkSeries &series);
+    void speedup(const BenchmarkSeries &slower, const BenchmarkSeries &faster);
+
+    // starts a table, every later row pads each value to its column's width
+    void columns(const std::vector<std::pair<std::string, std::streamsize>> &headers);
+
+    template <typename ...Values>
+    void row(const Values &...values);
+
+    // one row per pass, numbered, with a column for each series
+    void pass_table(const std::vector<BenchmarkSeries> &series);
+
+private:
+    std::ofstream file;
+    std::vector<std::streamsize> widths;
+};
+
+template <typename ...Values>
+void BenchmarkReport::line(const Values &...values)
+{
+    (file << ... << values) << std::endl;
+}
+
+template <typename ...Values>
+void BenchmarkReport::row(const Values &...values)
+{
+    size_t column = 0;
+
+    ((file << std::setw(column < widths.size() ? widths[column] : 0) << values, ++column), ...);
+
+    file << std::endl;
+}
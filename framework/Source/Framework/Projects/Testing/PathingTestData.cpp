@@ -185,22 +185,16 @@ bool PathingTestData::calculate_distance(const WaypointList &path)
 {
     distCard = 0;
     distDiag = 0;
-    auto p0 = path.begin();
-    auto p1 = p0;
-    ++p1;
 
-    while (p1 != path.end())
+    for (size_t i = 1; i < path.size(); ++i)
     {
-        const auto g0 = terrain->get_grid_position(*p0);
-        const auto g1 = terrain->get_grid_position(*p1);
+        const auto g0 = terrain->get_grid_position(path[i - 1]);
+        const auto g1 = terrain->get_grid_position(path[i]);
 
         if (calculate_distance(g0, g1) == false)
         {
             return false;
         }
-
-        p0 = p1;
-        ++p1;
     }
 
     return true;
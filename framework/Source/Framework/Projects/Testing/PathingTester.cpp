@@ -13,12 +13,15 @@ written consent of DigiPen Institute of Technology is prohibited.
 
 #include <pch.h>
 #include "PathingTester.h"
+#include "Benchmark.h"
 #include "Core/Serialization.h"
 #include "Agent/AStarAgent.h"
+#include "Projects/ProjectTwo.h"
 #include <sstream>
 #include "Misc/Stopwatch.h"
 #include <iomanip>
 #include <fstream>
+#include <numeric>
 
 namespace fs = std::filesystem;
 
@@ -131,12 +134,45 @@ void PathTester::execute_all_tests()
     }
 }
 
+void PathTester::execute_benchmarks()
+{
+    // the benchmarks only need the speed test's paths, not the rest of the test system
+    if (speedPaths.empty() == true)
+    {
+        Serialization::deserialize(speedPaths, Serialization::testsPath / "Speed.txt");
+    }
+
+    if (speedPaths.empty() == true)
+    {
+        std::cout << "Unable to run the benchmarks without Tests/Speed.txt, ignoring request" << std::endl;
+        return;
+    }
+
+    std::cout << "Running pathfinding benchmarks, results are written to " << Serialization::outputPath << std::endl;
+
+    // every benchmark picks the maps it needs, so put the user back on theirs afterwards
+    const unsigned map = terrain->get_map_index();
+
+    execute_speed_test();
+    execute_weighting_benchmark();
+    execute_batch_speed_test();
+    execute_kernel_benchmark();
+    execute_heuristic_comparison();
+    execute_allocation_test();
+    execute_cooperative_benchmark();
+    execute_any_angle_benchmark();
+    execute_incremental_benchmark();
+
+    terrain->goto_map(map);
+}
+
 void PathTester::execute_speed_test()
 {
     terrain->goto_map(1);
 
     agent->set_heuristic_type(Heuristic::OCTILE);
     agent->set_heuristic_weight(1.01f);
+    agent->set_weighting_type(Weighting::STATIC);
     agent->set_debug_coloring(false);
     agent->set_movement_type(Movement::NONE);
     agent->set_method_type(Method::ASTAR);
@@ -144,63 +180,917 @@ void PathTester::execute_speed_test()
     agent->set_smoothing(false);
     agent->set_single_step(false);
 
-    Stopwatch timer;
+    // time whole searches, not budgeted slices of them or handing them to another thread
+    auto &scheduler = agents->get_path_scheduler();
+    const auto budget = scheduler.get_budget();
+    scheduler.set_budget(budget.zero());
+    pather->set_async_enabled(false);
+
+    const auto search = [&]()
+    {
+        for (const auto &[start, goal] : speedPaths)
+        {
+            agent->set_position(terrain->get_world_position(start));
+            agent->path_to(terrain->get_world_position(goal), false);
+        }
+    };
+
+    const auto series = time_passes(1000, { { "Microseconds", search } });
+
+    scheduler.set_budget(budget);
+    pather->set_async_enabled(true);
+
+    BenchmarkReport report("SpeedTest");
+    report.line("Fastest: ", series[0].fastest(), " microseconds");
+    report.line("Average: ", series[0].average(), " microseconds");
+    report.line();
+    report.pass_table(series);
+}
+
+void PathTester::execute_weighting_benchmark()
+{
+    terrain->goto_map(1);
+
+    // the speed test searches under each way of weighting them, all held to the same bound and measured against
+    // the optimal paths
+    struct WeightingRow
+    {
+        Weighting weighting;
+        float weight;
+        size_t expanded;
+        double worstRatio;
+        double length;
+    };
+
+    const float suboptimalBound = 1.5f;
+
+    std::array<WeightingRow, 4> weightingRows =
+    { {
+        { Weighting::STATIC, 1.0f, 0, 1.0, 0.0 },
+        { Weighting::STATIC, suboptimalBound, 0, 1.0, 0.0 },
+        { Weighting::DYNAMIC, suboptimalBound, 0, 1.0, 0.0 },
+        { Weighting::FOCAL, suboptimalBound, 0, 1.0, 0.0 }
+    } };
+
+    PathRequest request;
+    request.settings.heuristic = Heuristic::OCTILE;
+    request.settings.debugColoring = false;
+    request.settings.method = Method::ASTAR;
+    request.settings.rubberBanding = false;
+    request.settings.smoothing = false;
+    request.settings.singleStep = false;
+    request.settings.incremental = false;
+
+    // every request has to actually search
+    pather->set_path_cache_enabled(false);
+
+    std::vector<double> optimalLengths(speedPaths.size(), 0.0);
+    std::vector<std::pair<std::string, std::function<void()>>> contenders;
+
+    for (auto &row : weightingRows)
+    {
+        request.settings.weight = row.weight;
+        request.settings.weighting = row.weighting;
+
+        for (size_t i = 0; i < speedPaths.size(); ++i)
+        {
+            const auto &[start, goal] = speedPaths[i];
+            request.start = terrain->get_world_position(start);
+            request.goal = terrain->get_world_position(goal);
+            request.path.clear();
+            request.newRequest = true;
+            pather->compute_path(request);
+
+            row.expanded += pather->get_nodes_expanded();
+
+            double length = 0.0;
+            const Vec3 *previous = &request.start;
+
+            for (const auto &point : request.path)
+            {
+                length += Vec3::Distance(*previous, point);
+                previous = &point;
+            }
+
+            // the first row is the optimal search
+            if (&row == &weightingRows.front())
+            {
+                optimalLengths[i] = length;
+            }
+            else if (optimalLengths[i] > 0.0)
+            {
+                row.worstRatio = std::max(row.worstRatio, length / optimalLengths[i]);
+            }
+
+            row.length += length;
+        }
+
+        contenders.emplace_back(get_weighting_text(row.weighting), [&, weighting = row.weighting, weight = row.weight]()
+        {
+            request.settings.weight = weight;
+            request.settings.weighting = weighting;
+
+            for (const auto &[start, goal] : speedPaths)
+            {
+                request.start = terrain->get_world_position(start);
+                request.goal = terrain->get_world_position(goal);
+                request.path.clear();
+                request.newRequest = true;
+                pather->compute_path(request);
+            }
+        });
+    }
+
+    const size_t numPasses = 100;
+    const auto series = time_passes(numPasses, contenders);
+
+    pather->set_path_cache_enabled(true);
+
+    BenchmarkReport report("WeightingBenchmark");
+    report.line("Bound ", suboptimalBound, ", microseconds averaged over ", numPasses, " passes");
+    report.line();
+
+    const std::streamsize width = 10;
+
+    report.columns({ { "Mode", width }, { "Weight", width }, { "Expanded", width }, { "Microseconds", width * 2 },
+        { "Ratio", width }, { "Worst ratio", 0 } });
+
+    for (size_t r = 0; r < weightingRows.size(); ++r)
+    {
+        const auto &row = weightingRows[r];
+
+        report.row(series[r].name, row.weight, row.expanded, series[r].average(),
+            row.length / std::max(weightingRows.front().length, 1.0), row.worstRatio);
+    }
+}
+
+void PathTester::execute_batch_speed_test()
+{
+    terrain->goto_map(1);
+
+    // the same searches as the speed test, issued all at once like a spawn wave would
+    PathRequest::Settings settings;
+    settings.heuristic = Heuristic::OCTILE;
+    settings.weight = 1.01f;
+    settings.weighting = Weighting::STATIC;
+    settings.debugColoring = false;
+    settings.method = Method::ASTAR;
+    settings.rubberBanding = false;
+    settings.smoothing = false;
+    settings.singleStep = false;
+    settings.incremental = false;
+
+    std::vector<PathRequest> requests(speedPaths.size());
+    std::vector<PathResult> outcomes(speedPaths.size());
+
+    for (size_t i = 0; i < speedPaths.size(); ++i)
+    {
+        const auto &[start, goal] = speedPaths[i];
+        requests[i].start = terrain->get_world_position(start);
+        requests[i].goal = terrain->get_world_position(goal);
+        requests[i].settings = settings;
+    }
+
+    const auto serial = [&]()
+    {
+        for (auto &request : requests)
+        {
+            request.path.clear();
+            request.newRequest = true;
+            pather->compute_path(request);
+        }
+    };
+
+    const auto batched = [&]()
+    {
+        for (auto &request : requests)
+        {
+            request.path.clear();
+        }
+
+        pather->compute_paths(requests.data(), outcomes.data(), requests.size());
+    };
+
+    const auto series = time_passes(1000, { { "Serial", serial }, { "Batched", batched } });
+
+    BenchmarkReport report("BatchSpeedTest");
+    report.line("Requests per batch: ", requests.size());
+    report.line("Worker threads: ", std::max(1u, std::thread::hardware_concurrency()));
+    report.line();
+    report.summary(series[0]);
+    report.summary(series[1]);
+    report.speedup(series[0], series[1]);
+    report.line();
+    report.pass_table(series);
+}
+
+void PathTester::execute_kernel_benchmark()
+{
+    terrain->goto_map(1);
+
+    // the speed test searches, once through the specialized kernels and once through the runtime checked one,
+    // then unweighted through the specialized and the fixed point kernels, which only take weight one
+    PathRequest::Settings settings;
+    settings.heuristic = Heuristic::OCTILE;
+    settings.weight = 1.01f;
+    settings.weighting = Weighting::STATIC;
+    settings.debugColoring = false;
+    settings.method = Method::ASTAR;
+    settings.rubberBanding = false;
+    settings.smoothing = false;
+    settings.singleStep = false;
+    settings.incremental = false;
+
+    std::vector<PathRequest> requests(speedPaths.size());
+
+    for (size_t i = 0; i < speedPaths.size(); ++i)
+    {
+        const auto &[start, goal] = speedPaths[i];
+        requests[i].start = terrain->get_world_position(start);
+        requests[i].goal = terrain->get_world_position(goal);
+        requests[i].settings = settings;
+    }
+
+    // every iteration has to actually search
+    pather->set_path_cache_enabled(false);
+
+    const auto run = [&](AStarPather::KernelDispatch dispatch, float weight)
+    {
+        return [&, dispatch, weight]()
+        {
+            pather->set_kernel_dispatch(dispatch);
+
+            for (auto &request : requests)
+            {
+                request.path.clear();
+                request.newRequest = true;
+                request.settings.weight = weight;
+                pather->compute_path(request);
+            }
+        };
+    };
+
+    const auto series = time_passes(1000,
+    {
+        { "Specialized", run(AStarPather::KernelDispatch::SPECIALIZED, settings.weight) },
+        { "Runtime", run(AStarPather::KernelDispatch::RUNTIME, settings.weight) },
+        { "Unweighted float", run(AStarPather::KernelDispatch::SPECIALIZED, 1.0f) },
+        { "Fixed point", run(AStarPather::KernelDispatch::FIXED_POINT, 1.0f) }
+    });
+
+    pather->set_kernel_dispatch(AStarPather::KernelDispatch::SPECIALIZED);
+    pather->set_path_cache_enabled(true);
+
+    BenchmarkReport report("KernelBenchmark");
+    report.line("Requests per iteration: ", requests.size());
+    report.line();
+    report.summary(series[0]);
+    report.summary(series[1]);
+    report.speedup(series[1], series[0]);
+    report.line();
+    report.summary(series[2]);
+    report.summary(series[3]);
+    report.speedup(series[2], series[3]);
+    report.line();
+    report.pass_table(series);
+}
+
+void PathTester::execute_heuristic_comparison()
+{
+    // the maze map, where walls make the straight line heuristics the weakest
+    terrain->goto_map(2);
 
-    const size_t numIter = 1000;
+    const int maxRow = terrain->get_map_height() - 1;
+    const int maxCol = terrain->get_map_width() - 1;
 
-    using ms = std::chrono::microseconds;
-    std::array<ms, numIter> results;
-    ms::rep fastest = std::numeric_limits<ms::rep>().max();
-    ms::rep total = 0;
+    static constexpr unsigned numTests = 500;
+
+    std::vector<std::tuple<GridPos, GridPos>> points;
+    points.reserve(numTests);
+
+    while (points.size() < numTests)
+    {
+        const GridPos start { RNG::range(0, maxRow), RNG::range(0, maxCol) };
+        const GridPos goal { RNG::range(0, maxRow), RNG::range(0, maxCol) };
+
+        if (start != goal && terrain->is_wall(start) == false && terrain->is_wall(goal) == false)
+        {
+            points.emplace_back(start, goal);
+        }
+    }
+
+    PathRequest request;
+    request.settings.method = Method::ASTAR;
+    request.settings.weight = 1.0f;
+    request.settings.weighting = Weighting::STATIC;
+    request.settings.debugColoring = false;
+    request.settings.rubberBanding = false;
+    request.settings.smoothing = false;
+    request.settings.singleStep = false;
+    request.settings.incremental = false;
+
+    // every request has to actually search
+    pather->set_path_cache_enabled(false);
+
+    const Heuristic heuristics[] = { Heuristic::OCTILE, Heuristic::LANDMARK };
+    constexpr size_t numHeuristics = sizeof(heuristics) / sizeof(heuristics[0]);
+
+    std::array<std::vector<size_t>, numHeuristics> expanded;
+    std::array<size_t, numHeuristics> totals = {};
+    std::vector<std::pair<std::string, std::function<void()>>> contenders;
+
+    for (size_t h = 0; h < numHeuristics; ++h)
+    {
+        expanded[h].reserve(numTests);
+
+        contenders.emplace_back(get_heuristic_text(heuristics[h]), [&, h]()
+        {
+            request.settings.heuristic = heuristics[h];
+
+            for (const auto &[start, goal] : points)
+            {
+                request.start = terrain->get_world_position(start);
+                request.goal = terrain->get_world_position(goal);
+                request.path.clear();
+                request.newRequest = true;
+                pather->compute_path(request);
+
+                expanded[h].push_back(pather->get_nodes_expanded());
+                totals[h] += expanded[h].back();
+            }
+        });
+    }
+
+    const auto series = time_passes(1, contenders);
+
+    pather->set_path_cache_enabled(true);
+
+    BenchmarkReport report("HeuristicComparison");
+    report.line("Paths: ", numTests);
+    report.line();
+
+    for (size_t h = 0; h < numHeuristics; ++h)
+    {
+        report.line(series[h].name, " expanded: ", totals[h], " total, ", totals[h] / numTests, " average");
+        report.line(series[h].name, " time: ", series[h].total(), " microseconds");
+    }
+
+    report.line("Expansions saved over ", series[0].name, ": ",
+        100.0 - 100.0 * static_cast<double>(totals[1]) / std::max<size_t>(totals[0], 1), "%");
+    report.line();
+
+    const std::streamsize width = 10;
+
+    report.columns({ { "Test #", width }, { "Start", width * 2 }, { "Goal", width * 2 },
+        { series[0].name, width * 2 }, { series[1].name, 0 } });
+
+    for (size_t i = 0; i < numTests; ++i)
+    {
+        const auto &[start, goal] = points[i];
+
+        report.row(std::to_string(i + 1) + ":", std::to_string(start.row) + ", " + std::to_string(start.col),
+            std::to_string(goal.row) + ", " + std::to_string(goal.col), expanded[0][i], expanded[1][i]);
+    }
+}
+
+void PathTester::execute_allocation_test()
+{
+    if (speedPaths.empty() == true)
+    {
+        return;
+    }
+
+    terrain->goto_map(1);
+
+    // the speed test searches, all written into one request the way an agent reuses its own
+    PathRequest request;
+    request.settings.heuristic = Heuristic::OCTILE;
+    request.settings.weight = 1.01f;
+    request.settings.weighting = Weighting::STATIC;
+    request.settings.debugColoring = false;
+    request.settings.method = Method::ASTAR;
+    request.settings.rubberBanding = false;
+    request.settings.smoothing = false;
+    request.settings.singleStep = false;
+    request.settings.incremental = false;
+
+    // each pass empties the path cache, searches every path and remembers it, then runs them all again to be answered
+    // from the cache, a request allocated if the pather's buffers, its cache or the request's own path had to grow
+    const size_t numIter = 20;
+
+    std::array<size_t, numIter> searched = {};
+    std::array<size_t, numIter> cached = {};
+    size_t waypoints = 0;
+
+    const auto reserved = [&request]() { return pather->get_reserved_bytes() + request.path.capacity() * sizeof(Vec3); };
 
     for (size_t i = 0; i < numIter; ++i)
     {
-        timer.start();
+        pather->clear_path_cache();
 
-        for (const auto &[start, goal] : speedPaths)
+        for (auto *allocated : { &searched, &cached })
         {
-            agent->set_position(terrain->get_world_position(start));
-            agent->path_to(terrain->get_world_position(goal), false);
+            for (const auto &[start, goal] : speedPaths)
+            {
+                request.start = terrain->get_world_position(start);
+                request.goal = terrain->get_world_position(goal);
+                request.newRequest = true;
+                request.path.clear();
+
+                const size_t before = reserved();
+                pather->compute_path(request);
+
+                (*allocated)[i] += reserved() != before ? 1 : 0;
+                waypoints += request.path.size();
+            }
         }
+    }
+
+    const size_t numRequests = numIter * speedPaths.size() * 2;
+    const size_t warmAllocated = std::accumulate(searched.begin() + 1, searched.end(), size_t(0)) +
+        std::accumulate(cached.begin() + 1, cached.end(), size_t(0));
 
-        timer.stop();
+    BenchmarkReport report("AllocationTest");
+    report.line("Requests: ", numRequests, ", half searched and half answered by the path cache");
+    report.line("Waypoints: ", waypoints);
+    report.line("Requests that allocated on the first pass: ", searched[0] + cached[0]);
+    report.line("Requests that allocated on later passes: ", warmAllocated);
+    report.line();
 
-        results[i] = timer.microseconds();
+    const std::streamsize width = 10;
 
-        if (results[i].count() < fastest)
+    report.columns({ { "Pass #", width }, { "Searched", width * 2 }, { "Cached", 0 } });
+
+    for (size_t i = 0; i < numIter; ++i)
+    {
+        report.row(std::to_string(i + 1) + ":", searched[i], cached[i]);
+    }
+}
+
+void PathTester::execute_cooperative_benchmark()
+{
+    terrain->goto_map(1);
+
+    PathRequest request;
+    request.settings.heuristic = Heuristic::OCTILE;
+    request.settings.weight = 1.0f;
+    request.settings.weighting = Weighting::STATIC;
+    request.settings.debugColoring = false;
+    request.settings.method = Method::ASTAR;
+    request.settings.rubberBanding = false;
+    request.settings.smoothing = false;
+    request.settings.singleStep = false;
+    request.settings.incremental = false;
+
+    const int width = terrain->get_map_width();
+    const int height = terrain->get_map_height();
+
+    // every agent starts and ends on its own open cell, the same ones for every agent count
+    std::vector<int> openCells;
+
+    for (int cell = 0; cell < width * height; ++cell)
+    {
+        if (terrain->is_wall(cell / width, cell % width) == false)
+        {
+            openCells.push_back(cell);
+        }
+    }
+
+    std::vector<int> goalCells = openCells;
+    std::mt19937 shuffler(380);
+    std::shuffle(openCells.begin(), openCells.end(), shuffler);
+    std::shuffle(goalCells.begin(), goalCells.end(), shuffler);
+
+    const auto cell_position = [width](int cell) { return terrain->get_world_position(cell / width, cell % width); };
+
+    struct Row
+    {
+        size_t agents;
+        size_t plans;
+        size_t arrived;
+        size_t collisions;
+        std::chrono::nanoseconds time;
+    };
+
+    const size_t agentCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const unsigned numSteps = 200;
+
+    std::vector<Row> rows;
+    Stopwatch timer;
+
+    for (const size_t count : agentCounts)
+    {
+        if (count > openCells.size())
         {
-            fastest = results[i].count();
+            break;
         }
 
-        total += results[i].count();
+        // the agents walk the steps they're handed, planning again whenever they're halfway through a window
+        ReservationTable reservations;
+        reservations.resize(width * height);
+
+        std::vector<Vec3> positions(count);
+        std::vector<Vec3> goals(count);
+        std::vector<WaypointList> plans(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            positions[i] = cell_position(openCells[i]);
+            goals[i] = cell_position(goalCells[i]);
+        }
+
+        Row row { count, 0, 0, 0, std::chrono::nanoseconds(0) };
+        std::vector<unsigned> occupied(static_cast<size_t>(width * height), 0);
+
+        for (unsigned step = 0; step < numSteps; ++step)
+        {
+            reservations.advance();
+
+            // like AStarAgent, an agent about to plan holds its cell until it has
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (plans[i].size() < ReservationTable::window / 2)
+                {
+                    const auto cell = terrain->get_grid_position(positions[i]);
+
+                    for (int ahead = 0; ahead < ReservationTable::window; ++ahead)
+                    {
+                        reservations.reserve(cell.row * width + cell.col, reservations.get_time() + ahead, static_cast<unsigned short>(i + 1));
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (plans[i].size() < ReservationTable::window / 2)
+                {
+                    const auto owner = static_cast<unsigned short>(i + 1);
+
+                    request.start = positions[i];
+                    request.goal = goals[i];
+                    request.path.clear();
+                    request.newRequest = true;
+
+                    timer.start();
+                    reservations.release(owner);
+
+                    // and parks where it is if it can't reach its goal
+                    if (pather->compute_cooperative_path(request, reservations, owner) == PathResult::IMPOSSIBLE)
+                    {
+                        goals[i] = request.goal = positions[i];
+                        pather->compute_cooperative_path(request, reservations, owner);
+                    }
+
+                    timer.stop();
+
+                    row.time += timer.nanoseconds();
+                    ++row.plans;
+
+                    plans[i].clear();
+
+                    for (const auto &point : request.path)
+                    {
+                        plans[i].push_back(point);
+                    }
+                }
+
+                if (plans[i].empty() == false)
+                {
+                    positions[i] = plans[i].front();
+                    plans[i].advance();
+                }
+            }
+
+            // two agents in one cell at the end of a step means the reservations failed
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto cell = terrain->get_grid_position(positions[i]);
+
+                if (occupied[cell.row * width + cell.col] == step + 1)
+                {
+                    ++row.collisions;
+                }
+
+                occupied[cell.row * width + cell.col] = step + 1;
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto cell = terrain->get_grid_position(positions[i]);
+            row.arrived += cell.row * width + cell.col == goalCells[i] ? 1 : 0;
+        }
+
+        rows.push_back(row);
     }
 
-    std::stringstream filename;
-    filename << "Output/SpeedTest_";
-    Serialization::generate_time_stamp(filename);
-    filename << ".txt";
+    BenchmarkReport report("CooperativeBenchmark");
+    report.line("Timesteps: ", numSteps, ", window: ", ReservationTable::window, " steps");
+    report.line();
+
+    const std::streamsize width = 14;
+
+    report.columns({ { "Agents", width }, { "Plans", width }, { "Arrived", width }, { "Collisions", width },
+        { "Microseconds", width }, { "Plans/ms", width }, { "Agent steps/ms", 0 } });
+
+    for (const auto &row : rows)
+    {
+        const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(row.time).count();
+        const double ms = std::max(static_cast<double>(row.time.count()), 1.0) / 1000000.0;
+
+        report.row(row.agents, row.plans, row.arrived, row.collisions, microseconds, row.plans / ms, row.agents * numSteps / ms);
+    }
+}
 
-    std::ofstream file(filename.str());
+void PathTester::execute_any_angle_benchmark()
+{
+    PathRequest request;
+    request.settings.heuristic = Heuristic::OCTILE;
+    request.settings.weight = 1.0f;
+    request.settings.weighting = Weighting::STATIC;
+    request.settings.debugColoring = false;
+    request.settings.smoothing = false;
+    request.settings.singleStep = false;
+    request.settings.incremental = false;
+
+    // every request has to actually search
+    pather->set_path_cache_enabled(false);
+
+    // A* straightened afterwards against paths that come out of the search straight
+    struct Contender
+    {
+        Method method;
+        bool rubberBanding;
+        const char *name;
+    };
 
-    if (file)
+    const Contender contenders[] =
     {
-        file << "Fastest: " << fastest << " microseconds" << std::endl;
-        file << "Average: " << total / numIter << " microseconds" << std::endl << std::endl;
+        { Method::ASTAR, true, "A* + Rubberband" },
+        { Method::THETA_STAR, false, "Theta*" }
+    };
+
+    struct Row
+    {
+        size_t map;
+        const char *name;
+        size_t found;
+        double length;
+        size_t waypoints;
+        size_t expanded;
+        std::chrono::microseconds time;
+    };
+
+    static constexpr unsigned numTests = 200;
+
+    std::vector<Row> rows;
+    Stopwatch timer;
 
-        const std::streamsize width = 10;
+    for (size_t map = 0; map < terrain->num_maps(); ++map)
+    {
+        terrain->goto_map(static_cast<unsigned>(map));
 
-        file << std::left << std::setfill(' ');
+        const int maxRow = terrain->get_map_height() - 1;
+        const int maxCol = terrain->get_map_width() - 1;
 
-        file << std::setw(width) << "Test #" << "Microseconds" << std::endl;
-        std::string temp;
+        std::vector<std::tuple<GridPos, GridPos>> points;
+        points.reserve(numTests);
 
-        for (size_t i = 0; i < numIter; ++i)
+        // a map with almost no open cells can't supply the pairs
+        for (unsigned attempt = 0; attempt < numTests * 100 && points.size() < numTests; ++attempt)
         {
-            temp = std::to_string(i + 1) + ":";
-            file << std::setw(width) << temp << results[i].count() << std::endl;
+            const GridPos start { RNG::range(0, maxRow), RNG::range(0, maxCol) };
+            const GridPos goal { RNG::range(0, maxRow), RNG::range(0, maxCol) };
+
+            if (start != goal && terrain->is_wall(start) == false && terrain->is_wall(goal) == false)
+            {
+                points.emplace_back(start, goal);
+            }
         }
 
-        file.close();
+        for (const auto &contender : contenders)
+        {
+            request.settings.method = contender.method;
+            request.settings.rubberBanding = contender.rubberBanding;
+
+            Row row { map, contender.name, 0, 0.0, 0, 0, std::chrono::microseconds(0) };
+
+            for (const auto &[start, goal] : points)
+            {
+                request.start = terrain->get_world_position(start);
+                request.goal = terrain->get_world_position(goal);
+                request.path.clear();
+                request.newRequest = true;
+
+                timer.start();
+                const PathResult result = pather->compute_path(request);
+                timer.stop();
+
+                row.time += timer.microseconds();
+                row.expanded += pather->get_nodes_expanded();
+
+                if (result != PathResult::COMPLETE)
+                {
+                    continue;
+                }
+
+                ++row.found;
+                row.waypoints += request.path.size();
+
+                const Vec3 *previous = &request.start;
+
+                for (const auto &point : request.path)
+                {
+                    row.length += Vec3::Distance(*previous, point);
+                    previous = &point;
+                }
+            }
+
+            rows.push_back(row);
+        }
+    }
+
+    pather->set_path_cache_enabled(true);
+
+    BenchmarkReport report("AnyAngleBenchmark");
+    report.line("Paths per map: ", numTests, ", lengths in world units from the start position");
+    report.line();
+
+    const std::streamsize width = 14;
+
+    report.columns({ { "Map", width / 2 }, { "Method", width * 2 }, { "Found", width }, { "Length", width },
+        { "Waypoints", width }, { "Expanded", width }, { "Microseconds", 0 } });
+
+    for (const auto &row : rows)
+    {
+        report.row(row.map, row.name, row.found, row.length, row.waypoints, row.expanded, row.time.count());
+    }
+}
+
+void PathTester::execute_incremental_benchmark()
+{
+    PathRequest plain;
+    plain.settings.method = Method::ASTAR;
+    plain.settings.heuristic = Heuristic::OCTILE;
+    plain.settings.weight = 1.0f;
+    plain.settings.weighting = Weighting::STATIC;
+    plain.settings.debugColoring = false;
+    plain.settings.rubberBanding = false;
+    plain.settings.smoothing = false;
+    plain.settings.singleStep = false;
+    plain.settings.incremental = false;
+
+    // the chaser keeps one request for the whole chase, that's what its search is kept under
+    PathRequest chase;
+    chase.settings = plain.settings;
+    chase.settings.incremental = true;
+
+    // every plain request has to actually search
+    pather->set_path_cache_enabled(false);
+
+    // a target wandering a cell at a time and a chaser taking a step along its latest path after every replan, both
+    // searches asked the same thing each time
+    struct Row
+    {
+        size_t map;
+        size_t replans;
+        size_t incrementalExpanded;
+        size_t plainExpanded;
+        size_t longer;
+        std::chrono::microseconds incrementalTime;
+        std::chrono::microseconds plainTime;
+    };
+
+    static constexpr unsigned numReplans = 500;
+
+    const auto length = [](const PathRequest &request)
+    {
+        float total = 0.0f;
+        const Vec3 *previous = &request.start;
+
+        for (const auto &point : request.path)
+        {
+            total += Vec3::Distance(*previous, point);
+            previous = &point;
+        }
+
+        return total;
+    };
+
+    std::vector<Row> rows;
+    Stopwatch timer;
+
+    for (size_t map = 0; map < terrain->num_maps(); ++map)
+    {
+        terrain->goto_map(static_cast<unsigned>(map));
+
+        const int maxRow = terrain->get_map_height() - 1;
+        const int maxCol = terrain->get_map_width() - 1;
+
+        const auto random_open = [&]()
+        {
+            // a map with almost no open cells might not give one up
+            for (unsigned attempt = 0; attempt < 1000; ++attempt)
+            {
+                const GridPos cell { RNG::range(0, maxRow), RNG::range(0, maxCol) };
+
+                if (terrain->is_wall(cell) == false)
+                {
+                    return cell;
+                }
+            }
+
+            return GridPos { -1, -1 };
+        };
+
+        GridPos chaser = random_open();
+        GridPos target = random_open();
+
+        if (chaser.row == -1 || target.row == -1)
+        {
+            continue;
+        }
+
+        Row row { map, 0, 0, 0, 0, std::chrono::microseconds(0), std::chrono::microseconds(0) };
+
+        for (unsigned step = 0; step < numReplans; ++step)
+        {
+            const GridPos next { target.row + RNG::range(-1, 1), target.col + RNG::range(-1, 1) };
+
+            if (terrain->is_valid_grid_position(next) == true && terrain->is_wall(next) == false)
+            {
+                target = next;
+            }
+
+            // once caught the target turns up somewhere else
+            if (chaser == target)
+            {
+                target = random_open();
+            }
+
+            chase.start = terrain->get_world_position(chaser);
+            chase.goal = terrain->get_world_position(target);
+            chase.path.clear();
+            chase.newRequest = true;
+
+            timer.start();
+            const PathResult result = pather->compute_path(chase);
+            timer.stop();
+
+            row.incrementalTime += timer.microseconds();
+            row.incrementalExpanded += pather->get_nodes_expanded();
+
+            plain.start = chase.start;
+            plain.goal = chase.goal;
+            plain.path.clear();
+            plain.newRequest = true;
+
+            timer.start();
+            pather->compute_path(plain);
+            timer.stop();
+
+            row.plainTime += timer.microseconds();
+            row.plainExpanded += pather->get_nodes_expanded();
+            ++row.replans;
+
+            // walled off from each other, so the chase starts over somewhere else
+            if (result != PathResult::COMPLETE)
+            {
+                chaser = random_open();
+                target = random_open();
+                continue;
+            }
+
+            // both are optimal, so only rounding should ever tell them apart
+            row.longer += length(chase) > length(plain) + 0.001f ? 1 : 0;
+
+            if (chase.path.size() > 1)
+            {
+                chaser = terrain->get_grid_position(chase.path[1]);
+            }
+        }
+
+        rows.push_back(row);
+    }
+
+    pather->set_path_cache_enabled(true);
+
+    BenchmarkReport report("IncrementalBenchmark");
+    report.line("Replans per map: ", numReplans, ", expansions and microseconds are per replan");
+    report.line("Longer counts the incremental paths longer than the plain A* ones asked the same thing");
+    report.line();
+
+    const std::streamsize width = 14;
+
+    report.columns({ { "Map", width / 2 }, { "Replans", width }, { "Inc expanded", width }, { "A* expanded", width },
+        { "Longer", width }, { "Inc us", width }, { "A* us", 0 } });
+
+    for (const auto &row : rows)
+    {
+        const double replans = static_cast<double>(std::max<size_t>(row.replans, 1));
+
+        report.row(row.map, row.replans, row.incrementalExpanded / replans, row.plainExpanded / replans, row.longer,
+            row.incrementalTime.count() / replans, row.plainTime.count() / replans);
     }
 }
 
@@ -291,6 +1181,8 @@ void PathTester::bootstrap(const std::string &name, Method method, Heuristic heu
     settings.singleStep = false;
     settings.smoothing = false;
     settings.weight = weight;
+    settings.weighting = Weighting::STATIC;
+    settings.incremental = false;
 
     const auto smallName = name + "_Small";
     const auto largeName = name + "_Large";
@@ -34,7 +34,16 @@ public:
 
     void execute_current_test();
     void execute_all_tests();
+    void execute_benchmarks();
     void execute_speed_test();
+    void execute_weighting_benchmark();
+    void execute_batch_speed_test();
+    void execute_kernel_benchmark();
+    void execute_heuristic_comparison();
+    void execute_allocation_test();
+    void execute_cooperative_benchmark();
+    void execute_any_angle_benchmark();
+    void execute_incremental_benchmark();
 
     void tick();
 
@@ -0,0 +1,54 @@
+#pragma once
+#include "../Misc/NiceTypes.h"
+#include <vector>
+
+// the walls, costs and cell positions of one version of the map, the terrain builds a new one whenever the
+// walls change and never modifies one it has handed out, so other threads can read it without locking
+struct GridSnapshot
+{
+    unsigned mapIndex;
+    int width;
+    int height;
+
+    // the world size the map is stretched over, for converting world positions back into cells
+    float worldSize;
+
+    std::vector<unsigned char> walls;
+    std::vector<Vec3> positions;
+
+    // terrain cost of each cell, one on maps without a cost grid
+    std::vector<float> costs;
+
+    bool is_valid_grid_position(int row, int col) const
+    {
+        return row >= 0 && row < height && col >= 0 && col < width;
+    }
+
+    bool is_valid_grid_position(const GridPos &gridPos) const
+    {
+        return is_valid_grid_position(gridPos.row, gridPos.col);
+    }
+
+    bool is_wall(int row, int col) const
+    {
+        return walls[row * width + col] != 0;
+    }
+
+    bool is_wall(const GridPos &gridPos) const
+    {
+        return is_wall(gridPos.row, gridPos.col);
+    }
+
+    const Vec3 &get_world_position(int row, int col) const
+    {
+        return positions[row * width + col];
+    }
+
+    // the same mapping as Terrain::get_grid_position
+    GridPos get_grid_position(const Vec3 &worldPos) const
+    {
+        const int row = static_cast<int>(worldPos.x / worldSize * height);
+        const int col = static_cast<int>(worldPos.z / worldSize * height);
+        return GridPos { row, col };
+    }
+};
@@ -13,8 +13,80 @@ written consent of DigiPen Institute of Technology is prohibited.
 
 #pragma once
 #include "../Misc/NiceTypes.h"
+#include <cstdlib>
 
 float lerp(float value0, float value1, float t);
 
 // determines if two 2D lines intersect, each line is defined by two points
-bool line_intersect(const Vec2 &line0P0, const Vec2 &line0P1, const Vec2 &line1P0, const Vec2 &line1P1);
\ No newline at end of file
+bool line_intersect(const Vec2 &line0P0, const Vec2 &line0P1, const Vec2 &line1P0, const Vec2 &line1P1);
+
+// walks the straight line between two points through every cell it enters, in integers so the answer doesn't depend
+// on the size of the map or on rounding, the points are in half cells so cell (row, col) has its center at
+// (2 * row + 1, 2 * col + 1) and its top left corner at (2 * row, 2 * col), and a line between two corners mustn't
+// run along a grid line.  Entering a wall blocks the line, and so does passing exactly through the corner where
+// four cells meet if either cell beside it is a wall.  enter is called for each cell entered, the first one included
+template <typename IsWall, typename Enter>
+bool trace_grid_line(int row0, int col0, int row1, int col1, const IsWall &wall, const Enter &enter)
+{
+    const int rows = std::abs(row1 - row0);
+    const int cols = std::abs(col1 - col0);
+    const int rowStep = (row1 > row0) ? 1 : -1;
+    const int colStep = (col1 > col0) ? 1 : -1;
+
+    // the cell the line leaves its first point through
+    int row = (rowStep > 0) ? row0 / 2 : (row0 - 1) / 2;
+    int col = (colStep > 0) ? col0 / 2 : (col0 - 1) / 2;
+
+    if (wall(row, col))
+    {
+        return false;
+    }
+
+    enter(row, col);
+
+    // i and j are how far along the line the next row and column edges are, the next one crossed is whichever
+    // the line reaches first, compared by cross multiplying so nothing is ever divided
+    for (int i = 2 - (row0 & 1), j = 2 - (col0 & 1); i < rows || j < cols;)
+    {
+        const int rowCrossing = i * cols;
+        const int colCrossing = j * rows;
+
+        if (rowCrossing < colCrossing)
+        {
+            row += rowStep;
+            i += 2;
+        }
+        else if (rowCrossing > colCrossing)
+        {
+            col += colStep;
+            j += 2;
+        }
+        else
+        {
+            if (wall(row + rowStep, col) || wall(row, col + colStep))
+            {
+                return false;
+            }
+
+            row += rowStep;
+            col += colStep;
+            i += 2;
+            j += 2;
+        }
+
+        if (wall(row, col))
+        {
+            return false;
+        }
+
+        enter(row, col);
+    }
+
+    return true;
+}
+
+template <typename IsWall>
+bool trace_grid_line(int row0, int col0, int row1, int col1, const IsWall &wall)
+{
+    return trace_grid_line(row0, col0, row1, col1, wall, [](int, int) {});
+}
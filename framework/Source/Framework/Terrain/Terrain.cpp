@@ -14,7 +14,11 @@ written consent of DigiPen Institute of Technology is prohibited.
 #include <pch.h>
 #include "Terrain.h"
 #include "TerrainAnalysis.h"
+#include "MapMath.h"
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <bitset>
 #include "Core/Serialization.h"
 
 namespace fs = std::filesystem;
@@ -22,6 +26,37 @@ namespace fs = std::filesystem;
 namespace
 {
     const float layerHeightStep = -0.00001f;
+
+    // calls body once for every index below count, spread over the cores, each thread taking the next index nobody
+    // has started, so the uneven amounts of work the callers have per index still balance out
+    void for_each_in_parallel(int count, const std::function<void(int)> &body)
+    {
+        std::atomic<int> next(0);
+
+        auto worker = [&]()
+        {
+            for (int i = next++; i < count; i = next++)
+            {
+                body(i);
+            }
+        };
+
+        const unsigned numThreads = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned>(count)));
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads - 1);
+
+        for (unsigned t = 1; t < numThreads; ++t)
+        {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
 }
 
 Color Terrain::baseColor = Colors::White;
@@ -50,7 +85,11 @@ Terrain::Terrain() :
     agentVisionLayer("Agent Vision", layerHeightStep * 3.0f),
     fogLayer("Fog of War", layerHeightStep * 1.0f),
     seekLayer("Seek", layerHeightStep * 2.0f),
-    currentMap(-1)
+    costLayer("Terrain Cost", layerHeightStep * 10.0f),
+    wallDistanceLayer("Wall Distance", layerHeightStep * 11.0f),
+    visibilityStride(0),
+    currentMap(-1),
+    changedWall { -1, -1 }
 {}
 
 bool Terrain::initialize()
@@ -126,20 +165,55 @@ void Terrain::load_map_data(const fs::path &file)
             return;
         }
 
-        mapData.emplace_back(height, width);
-        auto &map = mapData.back();
+        MapData map(height, width);
 
         for (int h = 0; h < height; ++h)
         {
             for (int w = 0; w < width; ++w)
             {
                 int value = 0;
-                stream >> value;
+
+                if (!(stream >> value))
+                {
+                    std::cout << "Incomplete map grid in " << file << std::endl;
+                    return;
+                }
 
                 map.data[h][w] = !!value;
             }
         }
 
+        // an optional grid of terrain costs may follow the walls, like Serialization::extract_costs the map is
+        // left out if it's cut short or holds a cost the heuristics can't be scaled by
+        float cost = 0.0f;
+
+        if (stream >> cost)
+        {
+            for (int i = 0; i < height * width; ++i)
+            {
+                if (i > 0 && !(stream >> cost))
+                {
+                    std::cout << "Incomplete terrain costs in " << file << std::endl;
+                    return;
+                }
+
+                if (cost <= 0.0f)
+                {
+                    std::cout << "Invalid terrain cost at row " << i / width << ", column " << i % width << " in " << file <<
+                        ", costs must be positive numbers" << std::endl;
+                    return;
+                }
+
+                map.costs[i / width][i % width] = cost;
+            }
+        }
+        else if (stream.eof() == false)
+        {
+            std::cout << "Invalid terrain costs in " << file << std::endl;
+            return;
+        }
+
+        mapData.emplace_back(std::move(map));
     }
     else
     {
@@ -157,6 +231,9 @@ void Terrain::load_map(unsigned mapIndex)
     wallLayer.configure_bool(baseColor, wallColor);
     wallLayer.set_enabled(true);
 
+    // the costs are only read by the pathfinding, so the layer is never drawn
+    costLayer.populate_with_data(map.costs);
+
     // reinitialize the other map layers
     reset_path_layer();
 
@@ -172,9 +249,13 @@ void Terrain::load_map(unsigned mapIndex)
 
     generate_positions();
 
+    update_wall_distances();
+    update_visibility();
     refresh_static_analysis_layers();
 
     gen_graph();
+
+    build_snapshot();
     
     Messenger::send_message(Messages::MAP_CHANGE);
 }
@@ -191,6 +272,161 @@ void Terrain::configure_float_map_layer(MapLayer<float> &layer, int height, int
     layer.configure_float(c0, c1);
 }
 
+void Terrain::update_wall_distances()
+{
+    // the exact distance transform of Felzenszwalb and Huttenlocher, down each column then along each row, linear in
+    // the number of cells, the columns and rows just past the edges are walls so there's always one to be near
+    const int height = get_map_height();
+    const int width = get_map_width();
+
+    wallDistanceLayer.populate_with_value(height, width, 0.0f);
+
+    // squared distance to the nearest wall in the same column, with a column of walls on either side
+    std::vector<float> columns(static_cast<size_t>((width + 2) * height), 0.0f);
+    std::vector<int> run(height);
+
+    for (int col = 0; col < width; ++col)
+    {
+        for (int row = 0; row < height; ++row)
+        {
+            run[row] = is_wall(row, col) ? 0 : (row == 0 ? 1 : run[row - 1] + 1);
+        }
+
+        int below = 1;
+
+        for (int row = height - 1; row >= 0; --row)
+        {
+            below = is_wall(row, col) ? 0 : (row == height - 1 ? 1 : below + 1);
+
+            const float nearest = static_cast<float>(std::min(run[row], below));
+            columns[row * (width + 2) + col + 1] = nearest * nearest;
+        }
+    }
+
+    // each cell's squared distance along a row is the lowest of the parabolas rising from the cells in it,
+    // found by keeping the envelope of the ones that are lowest somewhere
+    const int count = width + 2;
+    std::vector<int> vertex(count);
+    std::vector<float> boundary(count + 1);
+
+    for (int row = 0; row < height; ++row)
+    {
+        const float *f = &columns[row * count];
+
+        const auto intersect = [f](int a, int b)
+        {
+            return ((f[b] + b * b) - (f[a] + a * a)) / static_cast<float>(2 * (b - a));
+        };
+
+        int k = 0;
+        vertex[0] = 0;
+        boundary[0] = -std::numeric_limits<float>::infinity();
+        boundary[1] = std::numeric_limits<float>::infinity();
+
+        for (int q = 1; q < count; ++q)
+        {
+            float s = intersect(vertex[k], q);
+
+            while (s <= boundary[k])
+            {
+                --k;
+                s = intersect(vertex[k], q);
+            }
+
+            ++k;
+            vertex[k] = q;
+            boundary[k] = s;
+            boundary[k + 1] = std::numeric_limits<float>::infinity();
+        }
+
+        k = 0;
+
+        for (int q = 1; q <= width; ++q)
+        {
+            while (boundary[k + 1] < q)
+            {
+                ++k;
+            }
+
+            const float offset = static_cast<float>(q - vertex[k]);
+            wallDistanceLayer.set_value(row, q - 1, std::sqrt(offset * offset + f[vertex[k]]));
+        }
+    }
+}
+
+void Terrain::update_visibility()
+{
+    const int height = get_map_height();
+    const int width = get_map_width();
+    const int numCells = height * width;
+
+    visibilityStride = (static_cast<size_t>(numCells) + 63) / 64;
+    visibility.assign(visibilityStride * numCells, 0);
+
+    std::vector<GridPos> open;
+    std::vector<unsigned char> walls(static_cast<size_t>(numCells));
+
+    for (int cell = 0; cell < numCells; ++cell)
+    {
+        walls[cell] = is_wall(cell / width, cell % width) ? 1 : 0;
+
+        if (walls[cell] == 0)
+        {
+            open.push_back(GridPos { cell / width, cell % width });
+        }
+    }
+
+    // lines of sight go both ways, so each pair is only traced from the first of its cells, and each thread only
+    // ever writes its own cell's bits
+    const int numOpen = static_cast<int>(open.size());
+
+    for_each_in_parallel(numOpen, [&](int k)
+    {
+        const int from = open[k].row * width + open[k].col;
+        uint64_t *bits = &visibility[visibilityStride * from];
+        bits[from >> 6] |= uint64_t(1) << (from & 63);
+
+        // each thread keeps one buffer for all the cells it traces from
+        thread_local std::vector<unsigned char> clear;
+        clear.resize(numOpen);
+        trace_clear_paths(walls.data(), width, open[k].row, open[k].col, open.data() + k + 1, numOpen - k - 1, clear.data());
+
+        for (int i = k + 1; i < numOpen; ++i)
+        {
+            if (clear[i - k - 1] != 0)
+            {
+                const int to = open[i].row * width + open[i].col;
+                bits[to >> 6] |= uint64_t(1) << (to & 63);
+            }
+        }
+    });
+
+    // then every cell copies in the pairs that were tested from the other end, into a separate buffer since the
+    // rows being read share words with the rows being filled in, and a word can't be read while another thread writes it
+    std::vector<uint64_t> mirrored(visibility.size(), 0);
+
+    for_each_in_parallel(numCells, [&](int to)
+    {
+        uint64_t *bits = &mirrored[visibilityStride * to];
+
+        for (int from = 0; from < to; ++from)
+        {
+            if ((visibility[visibilityStride * from + (to >> 6)] >> (to & 63)) & 1)
+            {
+                bits[from >> 6] |= uint64_t(1) << (from & 63);
+            }
+        }
+    });
+
+    for_each_in_parallel(numCells, [&](int cell)
+    {
+        for (size_t word = visibilityStride * cell; word < visibilityStride * (cell + 1); ++word)
+        {
+            visibility[word] |= mirrored[word];
+        }
+    });
+}
+
 void Terrain::refresh_static_analysis_layers()
 {
     if (opennessLayer.enabled == true)
@@ -252,6 +488,92 @@ bool Terrain::is_wall(const GridPos &gridPos) const
     return wallLayer.get_value(gridPos);
 }
 
+float Terrain::get_cost(int row, int col) const
+{
+    return costLayer.get_value(row, col);
+}
+
+float Terrain::get_cost(const GridPos &gridPos) const
+{
+    return costLayer.get_value(gridPos);
+}
+
+float Terrain::get_wall_distance(int row, int col) const
+{
+    return wallDistanceLayer.get_value(row, col);
+}
+
+bool Terrain::is_visible(int row0, int col0, int row1, int col1) const
+{
+    const size_t from = static_cast<size_t>(row0 * get_map_width() + col0);
+    const int to = row1 * get_map_width() + col1;
+
+    return ((visibility[visibilityStride * from + (to >> 6)] >> (to & 63)) & 1) != 0;
+}
+
+int Terrain::count_visible(int row, int col) const
+{
+    const uint64_t *bits = &visibility[visibilityStride * (row * get_map_width() + col)];
+    int count = 0;
+
+    for (size_t word = 0; word < visibilityStride; ++word)
+    {
+        count += static_cast<int>(std::bitset<64>(bits[word]).count());
+    }
+
+    return count;
+}
+
+void Terrain::toggle_wall(int row, int col)
+{
+    wallLayer.set_value(row, col, !wallLayer.get_value(row, col));
+    changedWall = GridPos { row, col };
+
+    // everything load_map derives from the walls
+    update_wall_distances();
+    update_visibility();
+    refresh_static_analysis_layers();
+    gen_graph();
+    build_snapshot();
+
+    Messenger::send_message(Messages::WALL_CHANGE);
+}
+
+const GridPos &Terrain::get_changed_wall() const
+{
+    return changedWall;
+}
+
+std::shared_ptr<const GridSnapshot> Terrain::get_snapshot() const
+{
+    return snapshot;
+}
+
+void Terrain::build_snapshot()
+{
+    // whoever still holds the old snapshot keeps it alive until they let go of it
+    auto grid = std::make_shared<GridSnapshot>();
+    grid->mapIndex = currentMap;
+    grid->width = get_map_width();
+    grid->height = get_map_height();
+    grid->worldSize = mapSizeInWorld;
+    grid->walls.resize(static_cast<size_t>(grid->width * grid->height));
+    grid->positions.resize(grid->walls.size());
+    grid->costs.resize(grid->walls.size());
+
+    for (int row = 0; row < grid->height; ++row)
+    {
+        for (int col = 0; col < grid->width; ++col)
+        {
+            grid->walls[row * grid->width + col] = is_wall(row, col) ? 1 : 0;
+            grid->positions[row * grid->width + col] = positions[row][col];
+            grid->costs[row * grid->width + col] = get_cost(row, col);
+        }
+    }
+
+    snapshot = grid;
+}
+
 bool Terrain::is_valid_grid_position(int row, int col) const
 {
     const auto &data = mapData[currentMap];
@@ -338,6 +660,8 @@ Terrain::MapData::MapData(int height, int width) : height(height), width(width)
     {
         row.resize(width, false);
     }
+
+    costs.assign(height, std::vector<float>(width, 1.0f));
 }
 
 void Terrain::gen_graph()
@@ -345,79 +669,91 @@ void Terrain::gen_graph()
     // Time
     auto start = std::chrono::high_resolution_clock::now();
 
-    // Get walls in map
-    for (int i{}; i < terrain->get_map_width(); ++i)
+    Walls.clear();
+    WallVertices.clear();
+    WallEdges.clear();
+    PathEdges.clear();
+
+    const int height = get_map_height();
+    const int width = get_map_width();
+
+    // cells off the map count as open, so the border isn't an obstacle
+    const auto wall = [this, height, width](int row, int col)
+    {
+        return row >= 0 && row < height && col >= 0 && col < width && is_wall(row, col);
+    };
+
+    // corner (row, col) is the top left corner of cell (row, col), at the same place in the world as the cell's edge
+    const float rowStep = mapSizeInWorld / static_cast<float>(height);
+    const float colStep = mapSizeInWorld / static_cast<float>(width);
+
+    const auto corner = [rowStep, colStep](int row, int col)
+    {
+        return Vec3(rowStep * row, 0.0f, colStep * col);
+    };
+
+    // Get walls in map, and the sides of them that face open ground, each shared side only once
+    for (int i{}; i < height; ++i)
     {
-        for (int j{}; j < terrain->get_map_height(); ++j)
+        for (int j{}; j < width; ++j)
         {
-            if (terrain->is_wall(i, j))
+            if (is_wall(i, j))
             {
-                GridPos wall;
-                wall.row = i;
-                wall.col = j;
-                Walls.push_back(wall);
-
-                // Wall vertices
-                Vec3 tl = terrain->get_world_position(i, j);
-                tl.x -= 2.5f;
-                tl.z += 2.5f;
-                WallVertices.push_back(tl);
-                Vec3 tr = terrain->get_world_position(i, j);
-                tr.x += 2.5f;
-                tr.z += 2.5f;
-                WallVertices.push_back(tr);
-                Vec3 bl = terrain->get_world_position(i, j);
-                bl.x -= 2.5f;
-                bl.z -= 2.5f;
-                WallVertices.push_back(bl);
-                Vec3 br = terrain->get_world_position(i, j);
-                br.x += 2.5f;
-                br.z -= 2.5f;
-                WallVertices.push_back(br);
-
-                // Wall edges
-                WallEdges.push_back(std::make_pair(tl, tr));
-                WallEdges.push_back(std::make_pair(tl, bl));
-                WallEdges.push_back(std::make_pair(bl, br));
-                WallEdges.push_back(std::make_pair(tr, br));
+                Walls.push_back(GridPos { i, j });
+
+                if (!wall(i - 1, j))
+                    WallEdges.push_back(std::make_pair(corner(i, j), corner(i, j + 1)));
+                if (!wall(i + 1, j))
+                    WallEdges.push_back(std::make_pair(corner(i + 1, j), corner(i + 1, j + 1)));
+                if (!wall(i, j - 1))
+                    WallEdges.push_back(std::make_pair(corner(i, j), corner(i + 1, j)));
+                if (!wall(i, j + 1))
+                    WallEdges.push_back(std::make_pair(corner(i, j + 1), corner(i + 1, j + 1)));
             }
         }
     }
 
-    
+    // Shortest paths only bend around convex corners, the ones touching a single wall cell, or two that only meet
+    // at that corner.  Corners inside a wall or in the bend of one are never needed
+    std::vector<GridPos> corners;
 
-    // First join all vertices to each other, even if intersecting wall
-    for (int i{}, k_start{ 4 }; i < WallVertices.size(); ++i, k_start += 4)
+    for (int i{}; i <= height; ++i)
     {
-        for (int j{}; j < 4; ++j)
+        for (int j{}; j <= width; ++j)
         {
-            for (int k{ k_start }; k < WallVertices.size(); ++k)
+            const bool tl = wall(i - 1, j - 1);
+            const bool tr = wall(i - 1, j);
+            const bool bl = wall(i, j - 1);
+            const bool br = wall(i, j);
+            const int count = tl + tr + bl + br;
+
+            if (count == 1 || (count == 2 && tl == br))
             {
-                add_edge(WallVertices[i], WallVertices[k]);
+                corners.push_back(GridPos { i, j });
+                WallVertices.push_back(corner(i, j));
             }
-            ++i;
         }
-        --i;
     }
 
+    // Join every pair of corners that can see each other, each corner keeping its own edges so they can be put
+    // together in the same order every time
+    const int numCorners = static_cast<int>(corners.size());
+    std::vector<std::vector<Edge>> found(corners.size());
 
-    // Check if line segment intersects with wall edge, if true, remove line
-    for (int i{}; i < Edges.size(); ++i)
+    for_each_in_parallel(numCorners, [&](int i)
     {
-        bool intersect{};
-        for (int j{}; j < WallEdges.size(); ++j)
+        for (int k{ i + 1 }; k < numCorners; ++k)
         {
-            if (!is_clear_path(Edges[i].start, Edges[i].end, WallEdges[j].first, WallEdges[j].second))
+            if (is_graph_line_clear(corners[i].row, corners[i].col, corners[k].row, corners[k].col))
             {
-                intersect = true;
-                break;
+                found[i].emplace_back(WallVertices[i], WallVertices[k]);
             }
         }
+    });
 
-        if (!intersect)
-        {
-            PathEdges.push_back(Edges[i]);
-        }
+    for (const auto &edges : found)
+    {
+        PathEdges.insert(PathEdges.end(), edges.begin(), edges.end());
     }
 
     auto end = std::chrono::high_resolution_clock::now();
@@ -430,15 +766,87 @@ void Terrain::gen_graph()
     walledges_size = std::to_wstring(WallEdges.size());
     pathedges_size = std::to_wstring(PathEdges.size());
 
-    TextGetter durGetter = std::bind(&Terrain::get_time, terrain.get());
-    auto durText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 64, L"Time:", durGetter);
+    // the fields read the strings above, so they only need making once
+    if (!graphReadout)
+    {
+        graphReadout = true;
 
-    TextGetter walledgeGetter = std::bind(&Terrain::get_walledges_size, terrain.get());
-    auto walledgeText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 96, L"Wall Edges:", walledgeGetter);
+        TextGetter durGetter = std::bind(&Terrain::get_time, terrain.get());
+        auto durText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 64, L"Time:", durGetter);
 
-    TextGetter pathedgeGetter = std::bind(&Terrain::get_pathedges_size, terrain.get());
-    auto pathedgeText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 128, L"Vis Edges:", pathedgeGetter);
+        TextGetter walledgeGetter = std::bind(&Terrain::get_walledges_size, terrain.get());
+        auto walledgeText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 96, L"Wall Edges:", walledgeGetter);
+
+        TextGetter pathedgeGetter = std::bind(&Terrain::get_pathedges_size, terrain.get());
+        auto pathedgeText = ui->create_value_text_field(UIAnchor::TOP_LEFT, 90, 128, L"Vis Edges:", pathedgeGetter);
+    }
+}
+
+bool Terrain::is_graph_line_clear(int row0, int col0, int row1, int col1) const
+{
+    // corners are whole numbers, so the line is walked through the cells it crosses without any rounding,
+    // the wall grid is all the lookup it needs
+    const int height = get_map_height();
+    const int width = get_map_width();
+
+    const auto wall = [this, height, width](int row, int col)
+    {
+        return row >= 0 && row < height && col >= 0 && col < width && is_wall(row, col);
+    };
+
+    const int rows = std::abs(row1 - row0);
+    const int cols = std::abs(col1 - col0);
+    const int rowStep = (row1 > row0) ? 1 : -1;
+    const int colStep = (col1 > col0) ? 1 : -1;
+
+    // along a grid line the cells on both sides are only touched, so it's only blocked by running between
+    // two walls, either down a shared side or through the corner where two walls meet
+    if (rows == 0 || cols == 0)
+    {
+        const int steps = rows + cols;
+        const int dRow = (rows == 0) ? 0 : rowStep;
+        const int dCol = (cols == 0) ? 0 : colStep;
+
+        // the cells on either side of the unit step from corner (row, col)
+        const auto side = [&](int row, int col, bool first)
+        {
+            if (dRow == 0)
+            {
+                const int c = (dCol > 0) ? col : col - 1;
+                return wall(first ? row - 1 : row, c);
+            }
+
+            const int r = (dRow > 0) ? row : row - 1;
+            return wall(r, first ? col - 1 : col);
+        };
+
+        for (int k = 0; k < steps; ++k)
+        {
+            const int row = row0 + dRow * k;
+            const int col = col0 + dCol * k;
+
+            if (side(row, col, true) && side(row, col, false))
+            {
+                return false;
+            }
+
+            if (k > 0)
+            {
+                const int prevRow = row - dRow;
+                const int prevCol = col - dCol;
+
+                if ((side(prevRow, prevCol, true) && side(row, col, false)) || (side(prevRow, prevCol, false) && side(row, col, true)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
 
+    // corners sit on the even half cells
+    return trace_grid_line(row0 * 2, col0 * 2, row1 * 2, col1 * 2, wall);
 }
 
 void Terrain::toggle_graph()
@@ -448,7 +856,7 @@ void Terrain::toggle_graph()
 
 void Terrain::add_edge(Vec3 start, Vec3 end)
 {
-    Edges.push_back(Edge(start, end));
+    PathEdges.push_back(Edge(start, end));
 }
 
 void Terrain::clear_graph()
@@ -456,7 +864,6 @@ void Terrain::clear_graph()
     Walls.clear();
     WallVertices.clear();
     WallEdges.clear();
-    Edges.clear();
     PathEdges.clear();
     showGraph = false;
 }
@@ -14,6 +14,8 @@ written consent of DigiPen Institute of Technology is prohibited.
 #pragma once
 #include "MapLayer.h"
 #include "../Misc/NiceTypes.h"
+#include "GridSnapshot.h"
+#include <memory>
 #include  <filesystem>
 
 
@@ -46,6 +48,26 @@ public:
     bool is_wall(int row, int col) const;
     bool is_wall(const GridPos &gridPos) const;
 
+    // the cost of crossing a cell relative to plain ground, from the map file's optional cost grid, always positive
+    float get_cost(int row, int col) const;
+    float get_cost(const GridPos &gridPos) const;
+
+    // the euclidean distance in cells from a cell's center to the nearest wall cell's, with everything off the map
+    // counting as wall, zero on walls, kept up to date whenever the walls change
+    float get_wall_distance(int row, int col) const;
+
+    // whether two open cells can see each other, a line between their centers crossing no wall, and how many open
+    // cells one can see counting itself, read from a table rebuilt whenever the walls change
+    bool is_visible(int row0, int col0, int row1, int col1) const;
+    int count_visible(int row, int col) const;
+
+    // flips one cell between wall and open and sends WALL_CHANGE, get_changed_wall says which cell it was
+    void toggle_wall(int row, int col);
+    const GridPos &get_changed_wall() const;
+
+    // a read only copy of the current walls and positions, rebuilt before MAP_CHANGE and WALL_CHANGE are sent
+    std::shared_ptr<const GridSnapshot> get_snapshot() const;
+
     bool is_valid_grid_position(int row, int col) const;
     bool is_valid_grid_position(const GridPos &gridPos) const;
 
@@ -95,6 +117,7 @@ public:
         int height;
         int width;
         std::vector<std::vector<bool>> data;
+        std::vector<std::vector<float>> costs;
     };
 private:
     MapLayer<bool> wallLayer;
@@ -106,11 +129,19 @@ private:
     MapLayer<float> agentVisionLayer;
     MapLayer<float> fogLayer;
     MapLayer<float> seekLayer;
+    MapLayer<float> costLayer;
+    MapLayer<float> wallDistanceLayer;
+
+    // one bit per pair of cells, each cell's bits starting on a fresh word
+    std::vector<uint64_t> visibility;
+    size_t visibilityStride;
 
     std::vector<MapData> mapData;
     std::vector<std::vector<Vec3>> positions;
 
     unsigned currentMap;
+    GridPos changedWall;
+    std::shared_ptr<const GridSnapshot> snapshot;
     std::vector<GridPos> Walls;
     std::vector<Vec3> WallVertices;
     std::vector<std::pair<Vec3, Vec3>> WallEdges;
@@ -119,10 +150,11 @@ private:
         Edge(Vec3 s, Vec3 e) : start{ s }, end{ e } {};
         Vec3 start, end;
     };
-    std::vector<Edge> Edges;
     std::vector<Edge> PathEdges;
     bool showGraph{};
+    bool graphReadout{};
     void draw_graph();
+    bool is_graph_line_clear(int row0, int col0, int row1, int col1) const;
 
     std::wstring duration;
     std::wstring pathedges_size;
@@ -132,11 +164,16 @@ private:
     void shutdown();
 
     void generate_positions();
+    void build_snapshot();
 
+    // the plain text format, height and width, then height rows of width 0 or 1 walls, then optionally height * width
+    // positive terrain costs, all separated by whitespace, the maps shipped in Maps are read by Serialization instead
     void load_map_data(const std::filesystem::path &file);
     void load_map(unsigned mapIndex);
 
     void configure_float_map_layer(MapLayer<float> &layer, int height, int width, const Color &color0, const Color &color1);
+    void update_wall_distances();
+    void update_visibility();
     void refresh_static_analysis_layers();
     void reset_path_layer();
 };
\ No newline at end of file
@@ -20,6 +20,8 @@ class MapLayer;
 
 float distance_to_closest_wall(int row, int col);
 bool is_clear_path(int row0, int col0, int row1, int col1);
+// is_clear_path from one cell to each target, walls holds one byte per cell, nonzero for a wall, row by row
+void trace_clear_paths(const unsigned char *walls, int width, int row, int col, const GridPos *targets, int count, unsigned char *clear);
 bool is_clear_path(Vec3 const& s1, Vec3 const& e1, Vec3 s2, Vec3 e2);
 void analyze_openness(MapLayer<float> &layer);
 void analyze_visibility(MapLayer<float> &layer);
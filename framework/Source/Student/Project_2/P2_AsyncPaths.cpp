@@ -0,0 +1,311 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+
+/*
+    Background path requests.
+
+    A couple of long lived threads take requests off a queue and search them to completion with
+    their own search state, reading only the grid snapshot and the pather's tables.  Those are
+    only rebuilt from the game thread while the workers are paused, so a search never sees a
+    half changed map, and a table a wall change left stale is rebuilt before a request that
+    reads it is queued.  Results sit until their owner polls for them, once per frame from its update.
+
+    The path cache belongs to the game thread, so submit_path looks requests up in it before
+    queueing them and poll_path remembers the results the workers hand back.  A hierarchical
+    search refines its abstract path a leg at a time, and each stretch is handed over as it's
+    refined so the agent can start walking, the way the path scheduler's frame slices do it for
+    requests that run on the game thread.  Background requests have no frame to hold up, so the
+    scheduler's time budget doesn't apply to them.
+
+    Requests still waiting when the map changes are dropped, their owners forget their handles on
+    the same message.  A wall change keeps them, they are searched against the new walls.
+*/
+
+namespace
+{
+    // the game thread and the batch pool keep the rest of the cores
+    const unsigned asyncWorkerCount = 2;
+}
+
+PathHandle AStarPather::submit_path(const PathRequest &request)
+{
+    AsyncJob job { 0, request, PathResult::PROCESSING, cacheEnabled };
+    job.request.path.clear();
+
+    // the batch states are only used from inside compute_paths, which can't be running now
+    SearchState &state = workerSearches[0];
+    const bool cached = cacheEnabled == true && pathCache.find(cache_key(request), width, state.cellPath) == true;
+
+    if (cached == true)
+    {
+        job.cache = false;
+        job.result = state.cellPath.empty() == true ? PathResult::IMPOSSIBLE : PathResult::COMPLETE;
+
+        if (job.result == PathResult::COMPLETE)
+        {
+            emit_path(state, job.request);
+        }
+    }
+    else
+    {
+        // the workers only ever read the tables, so any a wall change left stale are rebuilt here first
+        refresh_tables(tables_for(request.settings));
+    }
+
+    std::unique_lock<std::mutex> lock(asyncMutex);
+
+    // zero means no request, so skip it when the count wraps
+    if (++lastHandle == 0)
+    {
+        ++lastHandle;
+    }
+
+    job.handle = lastHandle;
+
+    if (cached == true || asyncEnabled == false)
+    {
+        if (cached == false)
+        {
+            lock.unlock();
+            run_job(state, job);
+            lock.lock();
+        }
+
+        asyncDone.push_back(std::move(job));
+        return asyncDone.back().handle;
+    }
+
+    asyncQueue.push_back(std::move(job));
+    const PathHandle handle = asyncQueue.back().handle;
+    lock.unlock();
+
+    asyncWake.notify_one();
+
+    return handle;
+}
+
+PathResult AStarPather::poll_path(PathHandle handle, PathRequest &request)
+{
+    std::lock_guard<std::mutex> lock(asyncMutex);
+
+    // the request already holds any stretches handed over while the search was running
+    const auto hand_over = [&request](AsyncJob &job)
+    {
+        for (const auto &point : job.request.path)
+        {
+            request.path.push_back(point);
+        }
+
+        job.request.path.clear();
+    };
+
+    for (auto job = asyncDone.begin(); job != asyncDone.end(); ++job)
+    {
+        if (job->handle == handle)
+        {
+            const PathResult result = job->result;
+            hand_over(*job);
+
+            if (job->cache == true)
+            {
+                pathCache.insert(cache_key(job->request), job->cells);
+            }
+
+            asyncDone.erase(job);
+            return result;
+        }
+    }
+
+    for (AsyncJob *job : asyncRunning)
+    {
+        if (job->handle == handle)
+        {
+            hand_over(*job);
+            return PathResult::PROCESSING;
+        }
+    }
+
+    const auto waiting = [handle](const AsyncJob &job) { return job.handle == handle; };
+
+    if (std::find_if(asyncQueue.begin(), asyncQueue.end(), waiting) != asyncQueue.end())
+    {
+        return PathResult::PROCESSING;
+    }
+
+    return PathResult::IMPOSSIBLE;
+}
+
+void AStarPather::cancel_path(PathHandle handle)
+{
+    if (handle == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(asyncMutex);
+
+    const auto matches = [handle](const AsyncJob &job) { return job.handle == handle; };
+
+    asyncQueue.erase(std::remove_if(asyncQueue.begin(), asyncQueue.end(), matches), asyncQueue.end());
+    asyncDone.erase(std::remove_if(asyncDone.begin(), asyncDone.end(), matches), asyncDone.end());
+
+    // a running search can't be stopped, its result is thrown away when it finishes
+    const auto running = [handle](const AsyncJob *job) { return job->handle == handle; };
+
+    if (std::find_if(asyncRunning.begin(), asyncRunning.end(), running) != asyncRunning.end())
+    {
+        asyncCancelled.push_back(handle);
+    }
+}
+
+void AStarPather::set_async_enabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    asyncEnabled = enabled;
+}
+
+void AStarPather::on_test_begin()
+{
+    set_async_enabled(false);
+}
+
+void AStarPather::on_test_end()
+{
+    set_async_enabled(true);
+}
+
+void AStarPather::start_async()
+{
+    asyncStopping = false;
+    asyncPaused = false;
+    asyncSearches.resize(asyncWorkerCount);
+
+    for (unsigned worker = 0; worker < asyncWorkerCount; ++worker)
+    {
+        asyncThreads.emplace_back(&AStarPather::async_loop, this, worker);
+    }
+}
+
+void AStarPather::stop_async()
+{
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncStopping = true;
+    }
+
+    asyncWake.notify_all();
+
+    for (auto &thread : asyncThreads)
+    {
+        thread.join();
+    }
+
+    asyncThreads.clear();
+    asyncSearches.clear();
+    asyncQueue.clear();
+    asyncDone.clear();
+    asyncRunning.clear();
+    asyncCancelled.clear();
+}
+
+void AStarPather::pause_async()
+{
+    std::unique_lock<std::mutex> lock(asyncMutex);
+    asyncPaused = true;
+    asyncIdle.wait(lock, [this]() { return asyncRunning.empty() == true; });
+}
+
+void AStarPather::resume_async()
+{
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncPaused = false;
+    }
+
+    asyncWake.notify_all();
+}
+
+void AStarPather::async_loop(unsigned worker)
+{
+    while (true)
+    {
+        AsyncJob job;
+
+        {
+            std::unique_lock<std::mutex> lock(asyncMutex);
+            asyncWake.wait(lock, [this]() { return asyncStopping == true || (asyncPaused == false && asyncQueue.empty() == false); });
+
+            if (asyncStopping == true)
+            {
+                return;
+            }
+
+            job = std::move(asyncQueue.front());
+            asyncQueue.pop_front();
+            asyncRunning.push_back(&job);
+        }
+
+        run_job(asyncSearches[worker], job);
+
+        {
+            std::lock_guard<std::mutex> lock(asyncMutex);
+            asyncRunning.erase(std::find(asyncRunning.begin(), asyncRunning.end(), &job));
+
+            const auto cancelled = std::find(asyncCancelled.begin(), asyncCancelled.end(), job.handle);
+
+            if (cancelled != asyncCancelled.end())
+            {
+                asyncCancelled.erase(cancelled);
+            }
+            else
+            {
+                asyncDone.push_back(std::move(job));
+            }
+        }
+
+        asyncIdle.notify_all();
+    }
+}
+
+void AStarPather::run_job(SearchState &state, AsyncJob &job)
+{
+    // set_color isn't thread safe, and there's no later call to resume a single step from
+    auto settings = job.request.settings;
+    settings.debugColoring = false;
+    settings.singleStep = false;
+
+    // a hierarchical search out of time refines one more leg and returns, so with its time always up
+    // every leg comes back on its own and can be handed over before the next one is refined
+    const auto handOver = std::chrono::high_resolution_clock::time_point::min();
+    const auto *stopAt = settings.method == Method::HIERARCHICAL ? &handOver : nullptr;
+
+    job.request.newRequest = true;
+    job.result = run_search(state, job.request, settings, stopAt);
+
+    while (job.result != PathResult::IMPOSSIBLE)
+    {
+        // the cache keeps the whole path goal first, like a search leaves it, the stretches come start first
+        if (job.cache == true)
+        {
+            job.cells.insert(job.cells.end(), state.cellPath.rbegin(), state.cellPath.rend());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(asyncMutex);
+            emit_path(state, job.request);
+        }
+
+        if (job.result == PathResult::COMPLETE)
+        {
+            std::reverse(job.cells.begin(), job.cells.end());
+            return;
+        }
+
+        job.request.newRequest = false;
+        job.result = run_search(state, job.request, settings, stopAt);
+    }
+
+    // a path given up on after some of it was handed over isn't known to be impossible
+    job.cache = job.cache == true && job.request.newRequest == true;
+    job.cells.clear();
+}
@@ -0,0 +1,277 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+
+/*
+    Walkable region labels, so a request between regions is turned down without a search.
+
+    Diagonal moves need both cells beside them open, so two cells are in the same region exactly
+    when a chain of up, down, left and right steps joins them.  The labels are flood filled on map
+    change and patched when a single wall is toggled: opening a cell joins whatever regions touch
+    it, closing one only has to refill if its open neighbors aren't still joined around it.
+*/
+
+namespace
+{
+    // the eight cells around one, in order around it so each is beside the next
+    const AStarPather::Direction ring[AStarPather::NUM_DIRECTIONS] =
+    {
+        AStarPather::NORTH, AStarPather::NORTH_EAST, AStarPather::EAST, AStarPather::SOUTH_EAST,
+        AStarPather::SOUTH, AStarPather::SOUTH_WEST, AStarPather::WEST, AStarPather::NORTH_WEST
+    };
+}
+
+void AStarPather::on_wall_change()
+{
+    const GridPos cell = terrain->get_changed_wall();
+    const int changed = cell.row * width + cell.col;
+
+    // background searches keep going afterward against the new walls
+    pause_async();
+    grid = terrain->get_snapshot();
+
+    // only the cell and those around it gain or lose moves
+    for (int row = std::max(cell.row - 1, 0); row <= std::min(cell.row + 1, height - 1); ++row)
+    {
+        for (int col = std::max(cell.col - 1, 0); col <= std::min(cell.col + 1, width - 1); ++col)
+        {
+            neighbors[row * width + col] = neighbor_mask(row, col);
+        }
+    }
+
+    update_components(changed);
+
+    // every move that changed starts and ends in the cell or one around it, so repairing those nine lets each
+    // chaser's next request fix up only the distances that actually changed, unless its root was walled over
+    for (auto &state : incrementalSearches)
+    {
+        if (state.root == changed)
+        {
+            state.root = -1;
+        }
+
+        if (state.root == -1)
+        {
+            continue;
+        }
+
+        for (int row = std::max(cell.row - 1, 0); row <= std::min(cell.row + 1, height - 1); ++row)
+        {
+            for (int col = std::max(cell.col - 1, 0); col <= std::min(cell.col + 1, width - 1); ++col)
+            {
+                update_incremental(state, row * width + col);
+            }
+        }
+    }
+
+    // whatever else was remembered between requests assumed the old walls, a search already underway just finishes
+    pathCache.clear();
+    flowFields.clear();
+
+    staleTables = JUMP_DISTANCES | GOAL_BOUNDS | LANDMARKS | NEXT_HOPS;
+    build_abstract_graph(cell.row * width + cell.col);
+
+    // requests already queued were submitted while their tables were current, so those can't wait
+    unsigned char queued = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+
+        for (const auto &job : asyncQueue)
+        {
+            queued |= tables_for(job.request.settings);
+        }
+
+        // those already searched still reach their owners, but went by the old walls so aren't remembered
+        for (auto &job : asyncDone)
+        {
+            job.cache = false;
+        }
+    }
+
+    rebuild_tables(queued);
+
+    resume_async();
+}
+
+void AStarPather::label_components()
+{
+    components.assign(static_cast<size_t>(width * height), noComponent);
+    componentSizes.clear();
+
+    for (int index = 0; index < width * height; ++index)
+    {
+        if (components[index] == noComponent && terrain->is_wall(index / width, index % width) == false)
+        {
+            flood_component(index, new_component());
+        }
+    }
+}
+
+void AStarPather::update_components(int index)
+{
+    const int row = index / width;
+    const int col = index - row * width;
+    const unsigned short old = components[index];
+
+    if (terrain->is_wall(row, col) == false)
+    {
+        // join every region that touches the cell into the largest of them, so only the smaller ones are refilled
+        unsigned short largest = noComponent;
+
+        for (int d = 0; d < NORTH_EAST; ++d)
+        {
+            if ((neighbors[index] & (1 << d)) != 0)
+            {
+                const unsigned short id = components[index + rowOffset[d] * width + colOffset[d]];
+
+                if (largest == noComponent || componentSizes[id] > componentSizes[largest])
+                {
+                    largest = id;
+                }
+            }
+        }
+
+        flood_component(index, largest == noComponent ? new_component() : largest);
+        return;
+    }
+
+    if (old == noComponent)
+    {
+        return;
+    }
+
+    components[index] = noComponent;
+    --componentSizes[old];
+
+    if (splits_component(row, col) == false)
+    {
+        return;
+    }
+
+    // each side that is still labeled old after the ones before it were refilled is a region of its own,
+    // the first side keeps the old id
+    bool first = true;
+
+    for (int d = 0; d < NORTH_EAST; ++d)
+    {
+        const int r = row + rowOffset[d];
+        const int c = col + colOffset[d];
+
+        if (terrain->is_valid_grid_position(r, c) == false || components[r * width + c] != old)
+        {
+            continue;
+        }
+
+        if (first == true)
+        {
+            first = false;
+            continue;
+        }
+
+        flood_component(r * width + c, new_component());
+    }
+}
+
+unsigned short AStarPather::new_component()
+{
+    const auto free = std::find(componentSizes.begin(), componentSizes.end(), 0);
+
+    if (free != componentSizes.end())
+    {
+        return static_cast<unsigned short>(free - componentSizes.begin());
+    }
+
+    componentSizes.push_back(0);
+
+    return static_cast<unsigned short>(componentSizes.size() - 1);
+}
+
+void AStarPather::flood_component(int from, unsigned short id)
+{
+    // relabels everything joined to from that doesn't already have the id
+    std::vector<int> frontier;
+
+    const auto claim = [this, id, &frontier](int index)
+    {
+        const unsigned short old = components[index];
+
+        if (old != noComponent)
+        {
+            --componentSizes[old];
+        }
+
+        components[index] = id;
+        ++componentSizes[id];
+        frontier.push_back(index);
+    };
+
+    claim(from);
+
+    while (frontier.empty() == false)
+    {
+        const int current = frontier.back();
+        frontier.pop_back();
+
+        for (int d = 0; d < NORTH_EAST; ++d)
+        {
+            if ((neighbors[current] & (1 << d)) == 0)
+            {
+                continue;
+            }
+
+            const int next = current + rowOffset[d] * width + colOffset[d];
+
+            if (components[next] != id)
+            {
+                claim(next);
+            }
+        }
+    }
+}
+
+bool AStarPather::splits_component(int row, int col) const
+{
+    // if every open side of the new wall lies on one unbroken run of open cells around it, they're still
+    // joined through that run and the region is whole, otherwise they might only have been joined through it
+    bool open[NUM_DIRECTIONS];
+    int gap = -1;
+
+    for (int i = 0; i < NUM_DIRECTIONS; ++i)
+    {
+        const int r = row + rowOffset[ring[i]];
+        const int c = col + colOffset[ring[i]];
+
+        open[i] = terrain->is_valid_grid_position(r, c) == true && terrain->is_wall(r, c) == false;
+
+        if (open[i] == false)
+        {
+            gap = i;
+        }
+    }
+
+    if (gap == -1)
+    {
+        return false;
+    }
+
+    int runs = 0;
+    bool counted = false;
+
+    // start just past a closed cell so no run wraps around the end
+    for (int step = 1; step <= NUM_DIRECTIONS; ++step)
+    {
+        const int i = (gap + step) % NUM_DIRECTIONS;
+
+        if (open[i] == false)
+        {
+            counted = false;
+        }
+        else if (ring[i] < NORTH_EAST && counted == false)
+        {
+            counted = true;
+            ++runs;
+        }
+    }
+
+    return runs > 1;
+}
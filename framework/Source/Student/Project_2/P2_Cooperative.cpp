@@ -0,0 +1,152 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+
+/*
+    Windowed hierarchical cooperative A* (Silver).
+
+    Agents plan one at a time through a grid stacked over the next few timesteps, where every step
+    either moves to a neighbor or waits in place, and skip any cell another agent has already
+    claimed for that step.  The heuristic is the true distance to the goal with nobody else
+    around, read from the goal's flow field, so the search only has to work out how to get past
+    the others and a plan cut off at the end of the window still heads the right way.  Each agent
+    plans again before it walks off the end of its window, after the others have moved on.
+*/
+
+PathResult AStarPather::compute_cooperative_path(PathRequest &request, ReservationTable &reservations, unsigned short owner)
+{
+    auto &state = cooperative;
+
+    const GridPos start = grid->get_grid_position(request.start);
+    const GridPos goal = grid->get_grid_position(request.goal);
+
+    if (grid->is_valid_grid_position(start) == false || grid->is_valid_grid_position(goal) == false ||
+        grid->is_wall(start) == true || grid->is_wall(goal) == true)
+    {
+        return PathResult::IMPOSSIBLE;
+    }
+
+    const int startIndex = start.row * width + start.col;
+    const int goalIndex = goal.row * width + goal.col;
+
+    if (components[startIndex] != components[goalIndex])
+    {
+        return PathResult::IMPOSSIBLE;
+    }
+
+    const FlowFieldCache::Field *field = flowFields.find(goalIndex);
+
+    if (field == nullptr)
+    {
+        auto &fresh = flowFields.insert(goalIndex);
+        build_flow_field(goalIndex, fresh);
+        field = &fresh;
+    }
+
+    const int numCells = width * height;
+    const int lastStep = ReservationTable::window - 1;
+    const unsigned now = reservations.get_time();
+
+    state.begin(startIndex);
+    int end = -1;
+
+    while (state.openList.empty() == false)
+    {
+        const int current = state.pop();
+        const int step = current / numCells;
+        const int cell = current - step * numCells;
+
+        // stopping at the goal means staying there, so only once nobody else needs to pass through it
+        if ((cell == goalIndex && reservations.is_claimed_after(cell, now + step, owner) == false) || step == lastStep)
+        {
+            end = current;
+            break;
+        }
+
+        state.nodes[current].state = NodeState::CLOSED;
+
+        const unsigned char mask = neighbors[cell];
+        const float given = state.nodes[current].given;
+
+        // the ninth move is waiting in place
+        for (int d = 0; d <= NUM_DIRECTIONS; ++d)
+        {
+            int to = cell;
+            float cost = 1.0f;
+
+            if (d < NUM_DIRECTIONS)
+            {
+                if ((mask & (1 << d)) == 0)
+                {
+                    continue;
+                }
+
+                to = cell + rowOffset[d] * width + colOffset[d];
+                cost = edgeCosts[cell * NUM_DIRECTIONS + d];
+            }
+
+            if (reservations.blocks_move(cell, to, now + step, owner) == true)
+            {
+                continue;
+            }
+
+            const int next = current + numCells + (to - cell);
+            Node &node = state.touch(next);
+
+            if (node.state == NodeState::UNVISITED)
+            {
+                node.given = given + cost;
+                node.total = node.given + field->distance[to];
+                node.parent = current;
+                state.push(next);
+            }
+            else if (node.state == NodeState::OPEN && given + cost < node.given)
+            {
+                node.total -= node.given - (given + cost);
+                node.given = given + cost;
+                node.parent = current;
+                state.update(next);
+            }
+        }
+    }
+
+    if (end == -1)
+    {
+        // boxed in by the others for now, hold still and plan again next step
+        reservations.reserve(startIndex, now, owner);
+        return PathResult::PROCESSING;
+    }
+
+    auto &cellPath = state.cellPath;
+    cellPath.clear();
+
+    for (int index = end; index != -1; index = state.nodes[index].parent)
+    {
+        cellPath.push_back(index);
+    }
+
+    for (auto i = cellPath.rbegin(); i != cellPath.rend(); ++i)
+    {
+        const int step = *i / numCells;
+        const int cell = *i - step * numCells;
+
+        reservations.reserve(cell, now + step, owner);
+
+        if (step > 0)
+        {
+            request.path.push_back(grid->get_world_position(cell / width, cell % width));
+        }
+    }
+
+    if (end % numCells != goalIndex)
+    {
+        return PathResult::PROCESSING;
+    }
+
+    // parked on the goal for the rest of the window, which the check above made sure nobody else needs
+    for (int step = end / numCells + 1; step < ReservationTable::window; ++step)
+    {
+        reservations.reserve(goalIndex, now + step, owner);
+    }
+
+    return PathResult::COMPLETE;
+}
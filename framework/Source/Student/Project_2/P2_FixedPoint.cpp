@@ -0,0 +1,258 @@
+#include <pch.h>
+#include <intrin.h>
+#include "P2_Pathfinding.h"
+#include "Misc/Stopwatch.h"
+
+/*
+    Octile A* in integers.
+
+    A straight move costs 985 and a diagonal 1393, which is within 0.0004 of 985 times the square
+    root of two, so two paths only swap places when their true costs are within a thousandth of
+    each other unless one of them has thousands more diagonals than any of these maps can hold.
+    Costs add exactly, and with them being whole numbers the open list can be a ring of buckets
+    indexed by total cost instead of a heap.  With a consistent heuristic every open node costs
+    at most two diagonal moves more than the cheapest one, so a ring a bit wider than that never
+    has two live totals landing in the same bucket, and a bit per bucket finds the next occupied
+    one a word at a time.  Nodes within a bucket come off newest first, which already leans
+    toward the deeper of two equally good nodes.
+
+    Only plain octile or Chebyshev A* on maps without terrain costs can be searched this way,
+    select_kernel sends everything else to the float kernels.
+*/
+
+namespace
+{
+    const int fixedCardinal = 985;
+    const int fixedDiagonal = 1393;
+
+    // in the same order as the directions
+    const int fixedMoveCost[8] = { fixedCardinal, fixedCardinal, fixedCardinal, fixedCardinal,
+        fixedDiagonal, fixedDiagonal, fixedDiagonal, fixedDiagonal };
+
+    // a power of two wider than the largest spread of open totals
+    const int ringSize = 4096;
+    const int ringMask = ringSize - 1;
+    const int ringWords = ringSize / 64;
+
+    // reading the clock isn't free, so only check it every so often
+    const unsigned deadlineCheckMask = 63;
+}
+
+AStarPather::Kernel AStarPather::fixed_point_kernel(const PathRequest::Settings &settings) const
+{
+    if (settings.heuristic == Heuristic::CHEBYSHEV)
+    {
+        return &AStarPather::fixed_point_search<Heuristic::CHEBYSHEV>;
+    }
+
+    return &AStarPather::fixed_point_search<Heuristic::OCTILE>;
+}
+
+template <Heuristic H>
+PathResult AStarPather::fixed_point_search(SearchState &state, const PathRequest::Settings &settings,
+    const std::chrono::high_resolution_clock::time_point *stopAt) const
+{
+    auto &open = state.fixedPoint;
+    unsigned expansions = 0;
+
+    // begin put the start on the heap, move it over to the buckets
+    if (state.expanded == 0 && state.openList.empty() == false)
+    {
+        const int start = state.openList.front();
+        state.openList.clear();
+
+        open.reset();
+        open.given[start] = 0;
+        open.total[start] = fixed_point_heuristic<H>(state, start);
+        open.push(start);
+    }
+
+    while (open.count > 0)
+    {
+        const int current = open.pop();
+
+        if (current == state.goalIndex)
+        {
+            build_path(state, false);
+            return PathResult::COMPLETE;
+        }
+
+        state.nodes[current].state = NodeState::CLOSED;
+        ++state.expanded;
+
+        if (settings.debugColoring == true)
+        {
+            terrain->set_color(current / width, current % width, Colors::Yellow);
+        }
+
+        const unsigned char mask = neighbors[current];
+
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            if ((mask & (1 << d)) == 0)
+            {
+                continue;
+            }
+
+            const int next = current + rowOffset[d] * width + colOffset[d];
+            const int given = open.given[current] + fixedMoveCost[d];
+
+            Node &neighbor = state.touch(next);
+
+            if (neighbor.state == NodeState::UNVISITED)
+            {
+                neighbor.state = NodeState::OPEN;
+                neighbor.parent = current;
+                open.given[next] = given;
+                open.total[next] = given + fixed_point_heuristic<H>(state, next);
+                open.push(next);
+
+                if (settings.debugColoring == true)
+                {
+                    terrain->set_color(next / width, next % width, Colors::Blue);
+                }
+            }
+            else if (neighbor.state == NodeState::OPEN && given < open.given[next])
+            {
+                // the heuristic is consistent, so a closed node never gets any cheaper
+                open.remove(next);
+                open.total[next] -= open.given[next] - given;
+                open.given[next] = given;
+                neighbor.parent = current;
+                open.push(next);
+            }
+        }
+
+        if (settings.singleStep == true)
+        {
+            return PathResult::PROCESSING;
+        }
+
+        if (stopAt != nullptr && (++expansions & deadlineCheckMask) == 0 && Stopwatch::now() >= *stopAt)
+        {
+            return PathResult::PROCESSING;
+        }
+    }
+
+    return PathResult::IMPOSSIBLE;
+}
+
+template <Heuristic H>
+int AStarPather::fixed_point_heuristic(const SearchState &state, int index) const
+{
+    const int dRow = std::abs(index / width - state.goalPos.row);
+    const int dCol = std::abs(index % width - state.goalPos.col);
+
+    if constexpr (H == Heuristic::CHEBYSHEV)
+    {
+        return std::max(dRow, dCol) * fixedCardinal;
+    }
+    else
+    {
+        return std::min(dRow, dCol) * (fixedDiagonal - fixedCardinal) + std::max(dRow, dCol) * fixedCardinal;
+    }
+}
+
+void AStarPather::SearchState::FixedPointSearch::resize(size_t numCells)
+{
+    given.assign(numCells, 0);
+    total.assign(numCells, 0);
+    next.assign(numCells, -1);
+    previous.assign(numCells, -1);
+    heads.assign(ringSize, -1);
+    occupied.assign(ringWords, 0);
+    lowest = 0;
+    count = 0;
+}
+
+void AStarPather::SearchState::FixedPointSearch::reset()
+{
+    // only the buckets still holding nodes from an abandoned search need emptying
+    for (int word = 0; word < ringWords; ++word)
+    {
+        for (uint64_t bits = occupied[word]; bits != 0; bits &= bits - 1)
+        {
+            unsigned long bit;
+            _BitScanForward64(&bit, bits);
+            heads[word * 64 + static_cast<int>(bit)] = -1;
+        }
+
+        occupied[word] = 0;
+    }
+
+    lowest = 0;
+    count = 0;
+}
+
+void AStarPather::SearchState::FixedPointSearch::push(int index)
+{
+    const int bucket = total[index] & ringMask;
+    const int head = heads[bucket];
+
+    next[index] = head;
+    previous[index] = -1;
+
+    if (head != -1)
+    {
+        previous[head] = index;
+    }
+
+    heads[bucket] = index;
+    occupied[bucket >> 6] |= uint64_t(1) << (bucket & 63);
+
+    if (count++ == 0 || total[index] < lowest)
+    {
+        lowest = total[index];
+    }
+}
+
+int AStarPather::SearchState::FixedPointSearch::pop()
+{
+    // the first occupied bucket at or after the lowest total, going round the ring
+    const int from = lowest & ringMask;
+    int word = from >> 6;
+    uint64_t bits = occupied[word] & (~uint64_t(0) << (from & 63));
+
+    while (bits == 0)
+    {
+        word = (word + 1) % ringWords;
+        bits = occupied[word];
+    }
+
+    unsigned long bit;
+    _BitScanForward64(&bit, bits);
+
+    const int bucket = word * 64 + static_cast<int>(bit);
+    lowest += (bucket - from) & ringMask;
+
+    const int index = heads[bucket];
+    remove(index);
+
+    return index;
+}
+
+void AStarPather::SearchState::FixedPointSearch::remove(int index)
+{
+    const int bucket = total[index] & ringMask;
+
+    if (previous[index] != -1)
+    {
+        next[previous[index]] = next[index];
+    }
+    else
+    {
+        heads[bucket] = next[index];
+
+        if (next[index] == -1)
+        {
+            occupied[bucket >> 6] &= ~(uint64_t(1) << (bucket & 63));
+        }
+    }
+
+    if (next[index] != -1)
+    {
+        previous[next[index]] = previous[index];
+    }
+
+    --count;
+}
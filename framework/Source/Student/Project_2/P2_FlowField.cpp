@@ -0,0 +1,178 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+
+/*
+    Flow fields, for crowds converging on one point.
+
+    A single Dijkstra runs backward from the goal over the whole grid and records, for every cell,
+    its distance to the goal and the first step of a shortest route from it.  Every move is
+    reversible, so the backward search sees the same costs an agent walking forward would.
+    After that, any agent heading to the goal finds its next waypoint with one lookup instead
+    of a search of its own.
+*/
+
+namespace
+{
+    const float unreachable = std::numeric_limits<float>::infinity();
+}
+
+bool AStarPather::flow_waypoint(const Vec3 &position, const Vec3 &goal, Vec3 &waypoint)
+{
+    const GridPos from = terrain->get_grid_position(position);
+    const GridPos to = terrain->get_grid_position(goal);
+
+    if (terrain->is_valid_grid_position(from) == false || terrain->is_valid_grid_position(to) == false ||
+        terrain->is_wall(to) == true)
+    {
+        return false;
+    }
+
+    const int goalIndex = to.row * width + to.col;
+    const FlowFieldCache::Field *field = flowFields.find(goalIndex);
+
+    if (field == nullptr)
+    {
+        auto &fresh = flowFields.insert(goalIndex);
+        build_flow_field(goalIndex, fresh);
+        field = &fresh;
+    }
+
+    const int d = field->direction[from.row * width + from.col];
+
+    if (d == NUM_DIRECTIONS)
+    {
+        return false;
+    }
+
+    waypoint = terrain->get_world_position(from.row + rowOffset[d], from.col + colOffset[d]);
+
+    return true;
+}
+
+const FlowFieldCache &AStarPather::get_flow_fields() const
+{
+    return flowFields;
+}
+
+void AStarPather::build_flow_field(int goal, FlowFieldCache::Field &field) const
+{
+    const size_t numCells = static_cast<size_t>(width * height);
+    field.distance.assign(numCells, unreachable);
+    field.direction.assign(numCells, static_cast<unsigned char>(NUM_DIRECTIONS));
+
+    std::vector<std::pair<float, int>> frontier;
+    const auto later = std::greater<std::pair<float, int>>();
+
+    field.distance[goal] = 0.0f;
+    frontier.emplace_back(0.0f, goal);
+
+    while (frontier.empty() == false)
+    {
+        std::pop_heap(frontier.begin(), frontier.end(), later);
+        const auto [dist, current] = frontier.back();
+        frontier.pop_back();
+
+        if (dist > field.distance[current])
+        {
+            continue;
+        }
+
+        const unsigned char mask = neighbors[current];
+
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            if ((mask & (1 << d)) == 0)
+            {
+                continue;
+            }
+
+            const int next = current + rowOffset[d] * width + colOffset[d];
+            const float nextDist = dist + edgeCosts[current * NUM_DIRECTIONS + d];
+
+            if (nextDist < field.distance[next])
+            {
+                // the agent at next walks back the way the search came, cardinals and diagonals each pair up
+                // with the direction two places around from them
+                field.distance[next] = nextDist;
+                field.direction[next] = static_cast<unsigned char>(d < NORTH_EAST ? (d + 2) % 4 : NORTH_EAST + (d - NORTH_EAST + 2) % 4);
+                frontier.emplace_back(nextDist, next);
+                std::push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+    }
+}
+
+FlowFieldCache::FlowFieldCache(size_t capacity) : capacity(capacity), hits(0), misses(0),
+    textLookups(std::numeric_limits<size_t>::max()), textFields(0)
+{}
+
+const FlowFieldCache::Field *FlowFieldCache::find(int goal)
+{
+    const auto result = lookup.find(goal);
+
+    if (result == lookup.end())
+    {
+        ++misses;
+        return nullptr;
+    }
+
+    entries.splice(entries.begin(), entries, result->second);
+
+    ++hits;
+    return &result->second->field;
+}
+
+FlowFieldCache::Field &FlowFieldCache::insert(int goal)
+{
+    const auto result = lookup.find(goal);
+
+    if (result != lookup.end())
+    {
+        entries.splice(entries.begin(), entries, result->second);
+        return result->second->field;
+    }
+
+    if (entries.size() >= std::max<size_t>(capacity, 1))
+    {
+        // reuse the evicted field's buffers rather than allocating new ones
+        lookup.erase(entries.back().goal);
+        entries.splice(entries.begin(), entries, std::prev(entries.end()));
+        entries.front().goal = goal;
+    }
+    else
+    {
+        entries.emplace_front(Entry { goal, Field {} });
+    }
+
+    lookup[goal] = entries.begin();
+
+    return entries.front().field;
+}
+
+void FlowFieldCache::clear()
+{
+    entries.clear();
+    lookup.clear();
+}
+
+size_t FlowFieldCache::get_hits() const
+{
+    return hits;
+}
+
+size_t FlowFieldCache::get_misses() const
+{
+    return misses;
+}
+
+const std::wstring &FlowFieldCache::get_stats_text() const
+{
+    if (hits + misses != textLookups || entries.size() != textFields)
+    {
+        statsText = std::to_wstring(entries.size()) + L" fields, " + std::to_wstring(hits) + L" hit, " + std::to_wstring(misses) + L" miss";
+        textLookups = hits + misses;
+        textFields = entries.size();
+    }
+
+    return statsText;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+// bounded least recently used set of flow fields, one per goal cell, each holding every cell's distance
+// to the goal and which way to step to get there, so any number of agents heading to one goal share a single search
+class FlowFieldCache
+{
+public:
+    explicit FlowFieldCache(size_t capacity = 16);
+
+    struct Field
+    {
+        std::vector<float> distance;
+
+        // the direction to step from each cell, NUM_DIRECTIONS at the goal and wherever the goal can't be reached
+        std::vector<unsigned char> direction;
+    };
+
+    // nullptr when there is no field for the goal yet
+    const Field *find(int goal);
+
+    // makes room for a field, reusing the least recently used one's buffers, the caller fills it in
+    Field &insert(int goal);
+    void clear();
+
+    size_t get_hits() const;
+    size_t get_misses() const;
+    const std::wstring &get_stats_text() const;
+
+private:
+    struct Entry
+    {
+        int goal;
+        Field field;
+    };
+
+    // most recently used at the front
+    std::list<Entry> entries;
+    std::unordered_map<int, std::list<Entry>::iterator> lookup;
+    size_t capacity;
+
+    size_t hits;
+    size_t misses;
+
+    // formatted when the UI asks for it, and only if the counts moved since, so a lookup never allocates
+    mutable std::wstring statsText;
+    mutable size_t textLookups;
+    mutable size_t textFields;
+};
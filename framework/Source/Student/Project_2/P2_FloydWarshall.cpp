@@ -0,0 +1,377 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+#include "Misc/Stopwatch.h"
+#include <immintrin.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+    Floyd-Warshall all pairs next hop table.
+
+    The matrix is processed in tileSize x tileSize tiles.  For each diagonal tile k,
+    the diagonal tile is solved first, then every tile in row k and column k, then every
+    remaining tile.  Tiles within each of the last two phases are independent, so they're
+    split across threads, and the min-plus kernel inside a tile runs four columns at a
+    time with SSE2, the instruction set the project is built against, or eight at a time
+    when the build enables AVX.  When every move costs the same both ways the distances
+    do too, so only the tiles on and above the diagonal are relaxed and each is copied
+    flipped to its mirror image, which halves the work.
+
+    The kernel only tracks distances, which halves its memory traffic.  Once they're final,
+    the next hop for each pair is the neighbor the goal is cheapest to reach through, found
+    with a single pass over every vertex's (at most eight) edges.
+*/
+
+namespace
+{
+    const int tileSize = 32;
+
+    // beyond this the matrices stop fitting comfortably in memory, so those maps fall back to searching
+    const int maxTableVertices = 4096;
+    const unsigned short noNextHop = std::numeric_limits<unsigned short>::max();
+    const float unreachable = std::numeric_limits<float>::infinity();
+
+    // reusable rendezvous point for the worker threads between tile phases
+    class Barrier
+    {
+    public:
+        explicit Barrier(unsigned count) : count(count), waiting(0), phase(0)
+        {}
+
+        void arrive_and_wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            const unsigned arrivedPhase = phase;
+
+            if (++waiting == count)
+            {
+                waiting = 0;
+                ++phase;
+                condition.notify_all();
+            }
+            else
+            {
+                condition.wait(lock, [this, arrivedPhase]() { return phase != arrivedPhase; });
+            }
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        const unsigned count;
+        unsigned waiting;
+        unsigned phase;
+    };
+
+    // relaxes every pair in tile (rowTile, colTile) through the vertices of tile kTile
+    void relax_tile(float *distance, int stride, int rowTile, int colTile, int kTile)
+    {
+        const int rowBegin = rowTile * tileSize;
+        const int colBegin = colTile * tileSize;
+        const int kBegin = kTile * tileSize;
+
+        for (int k = kBegin; k < kBegin + tileSize; ++k)
+        {
+            const float *distanceK = distance + k * stride + colBegin;
+
+            for (int i = rowBegin; i < rowBegin + tileSize; ++i)
+            {
+                const float distanceIK = distance[i * stride + k];
+
+                if (distanceIK == unreachable)
+                {
+                    continue;
+                }
+
+                float *distanceI = distance + i * stride + colBegin;
+
+#ifdef __AVX__
+                const __m256 throughK = _mm256_set1_ps(distanceIK);
+
+                for (int j = 0; j < tileSize; j += 8)
+                {
+                    const __m256 candidate = _mm256_add_ps(throughK, _mm256_loadu_ps(distanceK + j));
+                    _mm256_storeu_ps(distanceI + j, _mm256_min_ps(candidate, _mm256_loadu_ps(distanceI + j)));
+                }
+#else
+                const __m128 throughK = _mm_set1_ps(distanceIK);
+
+                for (int j = 0; j < tileSize; j += 4)
+                {
+                    const __m128 candidate = _mm_add_ps(throughK, _mm_loadu_ps(distanceK + j));
+                    _mm_storeu_ps(distanceI + j, _mm_min_ps(candidate, _mm_loadu_ps(distanceI + j)));
+                }
+#endif
+            }
+        }
+    }
+
+    // copies tile (rowTile, colTile) over tile (colTile, rowTile), flipped, for a matrix that's the same both ways
+    void mirror_tile(float *distance, int stride, int rowTile, int colTile)
+    {
+        const int rowBegin = rowTile * tileSize;
+        const int colBegin = colTile * tileSize;
+
+        // four by four at a time, going down the columns a float at a time costs a third as much as relaxing the tile
+        for (int i = rowBegin; i < rowBegin + tileSize; i += 4)
+        {
+            for (int j = colBegin; j < colBegin + tileSize; j += 4)
+            {
+                __m128 row0 = _mm_loadu_ps(distance + i * stride + j);
+                __m128 row1 = _mm_loadu_ps(distance + (i + 1) * stride + j);
+                __m128 row2 = _mm_loadu_ps(distance + (i + 2) * stride + j);
+                __m128 row3 = _mm_loadu_ps(distance + (i + 3) * stride + j);
+
+                _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+                _mm_storeu_ps(distance + j * stride + i, row0);
+                _mm_storeu_ps(distance + (j + 1) * stride + i, row1);
+                _mm_storeu_ps(distance + (j + 2) * stride + i, row2);
+                _mm_storeu_ps(distance + (j + 3) * stride + i, row3);
+            }
+        }
+    }
+}
+
+void AStarPather::build_floyd_warshall()
+{
+    Stopwatch timer;
+    timer.start();
+
+    // only open cells take part, which keeps the matrix as small as possible
+    const int numCells = width * height;
+    cellToVertex.assign(numCells, -1);
+    vertexToCell.clear();
+
+    for (int cell = 0; cell < numCells; ++cell)
+    {
+        if (terrain->is_wall(cell / width, cell % width) == false)
+        {
+            cellToVertex[cell] = static_cast<int>(vertexToCell.size());
+            vertexToCell.push_back(cell);
+        }
+    }
+
+    const int numVertices = static_cast<int>(vertexToCell.size());
+
+    if (numVertices > maxTableVertices)
+    {
+        std::cout << "Map is too large for a Floyd-Warshall table, it will be searched instead" << std::endl;
+        fwStride = 0;
+        fwDistance.clear();
+        fwNext.clear();
+        return;
+    }
+
+    const int numTiles = (numVertices + tileSize - 1) / tileSize;
+    fwStride = numTiles * tileSize;
+
+    // padding vertices stay unreachable, so they never improve anything
+    fwDistance.assign(static_cast<size_t>(fwStride) * fwStride, unreachable);
+    fwNext.assign(static_cast<size_t>(fwStride) * fwStride, noNextHop);
+
+    for (int v = 0; v < numVertices; ++v)
+    {
+        const int cell = vertexToCell[v];
+        const unsigned char mask = neighbors[cell];
+
+        fwDistance[v * fwStride + v] = 0.0f;
+
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            if ((mask & (1 << d)) != 0)
+            {
+                const int u = cellToVertex[cell + rowOffset[d] * width + colOffset[d]];
+                fwDistance[v * fwStride + u] = edgeCosts[cell * NUM_DIRECTIONS + d];
+            }
+        }
+    }
+
+    // build_move_costs averages the costs of the two cells, so every move should cost the same both ways, and then
+    // the distances do as well, but the whole matrix is worked out if that ever stops being true
+    bool symmetric = true;
+
+    for (int v = 0; v < numVertices; ++v)
+    {
+        for (int u = 0; u < numVertices; ++u)
+        {
+            symmetric = symmetric && fwDistance[v * fwStride + u] == fwDistance[u * fwStride + v];
+        }
+    }
+
+    if (numTiles == 0)
+    {
+        return;
+    }
+
+    const unsigned numThreads = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned>(numTiles * numTiles)));
+    Barrier barrier(numThreads);
+
+    float *distance = fwDistance.data();
+    const int stride = fwStride;
+
+    auto worker = [&barrier, distance, stride, numTiles, numThreads, symmetric](unsigned id)
+    {
+        for (int k = 0; k < numTiles; ++k)
+        {
+            // phase one, the diagonal tile depends only on itself
+            if (id == 0)
+            {
+                relax_tile(distance, stride, k, k, k);
+            }
+
+            barrier.arrive_and_wait();
+
+            // phase two, the rest of row k and column k depend only on the diagonal tile
+            for (int task = static_cast<int>(id); task < (numTiles - 1) * 2; task += numThreads)
+            {
+                const int other = task / 2 < k ? task / 2 : task / 2 + 1;
+
+                if (task % 2 == 0)
+                {
+                    relax_tile(distance, stride, k, other, k);
+
+                    if (symmetric == true)
+                    {
+                        mirror_tile(distance, stride, k, other);
+                    }
+                }
+                else if (symmetric == false)
+                {
+                    relax_tile(distance, stride, other, k, k);
+                }
+            }
+
+            barrier.arrive_and_wait();
+
+            // phase three, every remaining tile depends only on its row k and column k tiles
+            for (int task = static_cast<int>(id); task < (numTiles - 1) * (numTiles - 1); task += numThreads)
+            {
+                const int row = task / (numTiles - 1);
+                const int col = task % (numTiles - 1);
+
+                if (symmetric == true && row > col)
+                {
+                    continue;
+                }
+
+                relax_tile(distance, stride, row < k ? row : row + 1, col < k ? col : col + 1, k);
+
+                if (symmetric == true && row != col)
+                {
+                    mirror_tile(distance, stride, row < k ? row : row + 1, col < k ? col : col + 1);
+                }
+            }
+
+            barrier.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+
+    for (unsigned t = 1; t < numThreads; ++t)
+    {
+        threads.emplace_back(worker, t);
+    }
+
+    worker(0);
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    build_next_hops();
+
+    timer.stop();
+    std::cout << "Floyd-Warshall built for " << numVertices << " vertices in " << timer.milliseconds().count() <<
+        " ms using " << numThreads << " threads" << std::endl;
+}
+
+void AStarPather::build_next_hops()
+{
+    const int numVertices = static_cast<int>(vertexToCell.size());
+
+    // the cheapest way found so far to each goal through a neighbor of the vertex being filled in
+    std::vector<float> best(numVertices);
+
+    for (int v = 0; v < numVertices; ++v)
+    {
+        const int cell = vertexToCell[v];
+        const unsigned char mask = neighbors[cell];
+        unsigned short *nextV = &fwNext[v * fwStride];
+
+        std::fill(best.begin(), best.end(), unreachable);
+
+        // the first step toward a goal is the neighbor it's cheapest to get there through, taking the smallest
+        // sum rather than the first within a tolerance means rounding in the distances can't leave a goal the
+        // vertex reaches without one, however long or cheap the paths are
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            if ((mask & (1 << d)) == 0)
+            {
+                continue;
+            }
+
+            const int u = cellToVertex[cell + rowOffset[d] * width + colOffset[d]];
+            const float *distanceU = &fwDistance[u * fwStride];
+            const float cost = edgeCosts[cell * NUM_DIRECTIONS + d];
+
+            for (int goal = 0; goal < numVertices; ++goal)
+            {
+                const float through = cost + distanceU[goal];
+
+                if (through < best[goal])
+                {
+                    best[goal] = through;
+                    nextV[goal] = static_cast<unsigned short>(u);
+                }
+            }
+        }
+
+        nextV[v] = noNextHop;
+    }
+}
+
+PathResult AStarPather::compute_table_path(SearchState &state, int startIndex) const
+{
+    const int start = cellToVertex[startIndex];
+    const int goal = cellToVertex[state.goalIndex];
+
+    if (fwDistance[start * fwStride + goal] == unreachable)
+    {
+        return PathResult::IMPOSSIBLE;
+    }
+
+    // follow the next hops from the start, then flip to the goal to start order a search leaves behind
+    auto &cellPath = state.cellPath;
+    cellPath.clear();
+
+    // no path visits a vertex twice, so a walk any longer than that has gone round in circles, which moves
+    // too cheap to show up in the rounding of the distances beside them can do, and the request is searched instead
+    const int numVertices = static_cast<int>(vertexToCell.size());
+
+    for (int v = start; v != goal; v = fwNext[v * fwStride + goal])
+    {
+        if (v == noNextHop)
+        {
+            cellPath.clear();
+            return PathResult::IMPOSSIBLE;
+        }
+
+        if (static_cast<int>(cellPath.size()) >= numVertices)
+        {
+            cellPath.clear();
+            return PathResult::PROCESSING;
+        }
+
+        cellPath.push_back(vertexToCell[v]);
+    }
+
+    cellPath.push_back(state.goalIndex);
+    std::reverse(cellPath.begin(), cellPath.end());
+
+    return PathResult::COMPLETE;
+}
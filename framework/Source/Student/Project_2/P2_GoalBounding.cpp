@@ -0,0 +1,276 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+#include "P2_SearchKernel.h"
+#include "Misc/Murmur2Hash.h"
+#include "Misc/Stopwatch.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <cstring>
+
+/*
+    Goal bounding (Rabin, Game AI Pro 3).
+
+    For every cell, a Dijkstra flood records which outgoing edge each reachable goal's
+    optimal path leaves through, and each edge keeps the bounding box of those goals.
+    A search can then skip any edge whose box doesn't contain the goal.  The floods are
+    independent, so they're split across threads, and the finished tables are cached on
+    disk keyed by a hash of the map so a restart can load them instead.  Only the tables
+    for maps as they load are saved, not those for walls toggled at runtime.
+*/
+
+namespace
+{
+    const uint32_t cacheMagic = 0x44424F47; // "GOBD"
+    const uint32_t cacheVersion = 1;
+
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        uint64_t hash;
+    };
+
+    const short emptyMin = std::numeric_limits<short>::max();
+    const short emptyMax = std::numeric_limits<short>::min();
+}
+
+void AStarPather::build_goal_bounds(bool save)
+{
+    const int numCells = width * height;
+
+    goalBounds.assign(static_cast<size_t>(numCells * NUM_DIRECTIONS), BoundingBox { emptyMin, emptyMax, emptyMin, emptyMax });
+
+    const size_t hash = map_hash();
+    const auto file = Serialization::mapsPath / "GoalBounding" / goal_bounds_filename(hash);
+
+    if (load_goal_bounds(file, hash) == true)
+    {
+        return;
+    }
+
+    Stopwatch timer;
+    timer.start();
+
+    // each worker claims source cells off a shared counter and owns its own flood buffers,
+    // the neighbor masks are read only and every source writes to a disjoint slice of the table
+    std::atomic<int> nextSource(0);
+
+    auto worker = [this, &nextSource, numCells]()
+    {
+        std::vector<float> distance(numCells);
+        std::vector<unsigned char> firstMove(numCells);
+        std::vector<std::pair<float, int>> frontier;
+        frontier.reserve(numCells * NUM_DIRECTIONS);
+
+        for (int source = nextSource++; source < numCells; source = nextSource++)
+        {
+            if (neighbors[source] != 0)
+            {
+                compute_goal_bounds_from(source, distance, firstMove, frontier);
+            }
+        }
+    };
+
+    const unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+
+    for (unsigned t = 1; t < numThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    timer.stop();
+    std::cout << "Goal bounding built in " << timer.milliseconds().count() << " ms using " << numThreads << " threads" << std::endl;
+
+    if (save == true)
+    {
+        save_goal_bounds(file, hash);
+    }
+}
+
+void AStarPather::compute_goal_bounds_from(int source, std::vector<float> &distance, std::vector<unsigned char> &firstMove,
+    std::vector<std::pair<float, int>> &frontier)
+{
+    std::fill(distance.begin(), distance.end(), std::numeric_limits<float>::max());
+    distance[source] = 0.0f;
+
+    // lazy deletion min heap, stale entries are skipped when popped
+    frontier.clear();
+    frontier.emplace_back(0.0f, source);
+
+    const auto later = std::greater<std::pair<float, int>>();
+
+    while (frontier.empty() == false)
+    {
+        std::pop_heap(frontier.begin(), frontier.end(), later);
+        const auto [dist, current] = frontier.back();
+        frontier.pop_back();
+
+        if (dist > distance[current])
+        {
+            continue;
+        }
+
+        if (current != source)
+        {
+            const int row = current / width;
+            const int col = current - row * width;
+
+            auto &box = goalBounds[source * NUM_DIRECTIONS + firstMove[current]];
+            box.minRow = std::min(box.minRow, static_cast<short>(row));
+            box.maxRow = std::max(box.maxRow, static_cast<short>(row));
+            box.minCol = std::min(box.minCol, static_cast<short>(col));
+            box.maxCol = std::max(box.maxCol, static_cast<short>(col));
+        }
+
+        const unsigned char mask = neighbors[current];
+
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            if ((mask & (1 << d)) == 0)
+            {
+                continue;
+            }
+
+            const int next = current + rowOffset[d] * width + colOffset[d];
+            const float nextDist = dist + edgeCosts[current * NUM_DIRECTIONS + d];
+
+            if (nextDist < distance[next])
+            {
+                distance[next] = nextDist;
+                firstMove[next] = (current == source) ? static_cast<unsigned char>(d) : firstMove[current];
+                frontier.emplace_back(nextDist, next);
+                std::push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+    }
+}
+
+AStarPather::Kernel AStarPather::bounded_kernel(const PathRequest::Settings &settings) const
+{
+    return specialized_kernel<Method::GOAL_BOUNDING>(settings, uniformCost == false);
+}
+
+template <typename Policy>
+void AStarPather::expand_bounded_neighbors(SearchState &state, int current, const PathRequest::Settings &settings) const
+{
+    const unsigned char mask = neighbors[current];
+    const BoundingBox *boxes = &goalBounds[current * NUM_DIRECTIONS];
+    const GridPos &goalPos = state.goalPos;
+
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        const auto &box = boxes[d];
+
+        if ((mask & (1 << d)) != 0 &&
+            goalPos.row >= box.minRow && goalPos.row <= box.maxRow &&
+            goalPos.col >= box.minCol && goalPos.col <= box.maxCol)
+        {
+            relax<Policy>(state, current, current + rowOffset[d] * width + colOffset[d], move_cost<Policy>(current, d), settings);
+        }
+    }
+}
+
+// the runtime kernel in P2_Pathfinding.cpp expands through this one
+template void AStarPather::expand_bounded_neighbors<RuntimeSearchPolicy>(SearchState &state, int current,
+    const PathRequest::Settings &settings) const;
+
+size_t AStarPather::map_hash() const
+{
+    // the walls and terrain costs fully determine the tables, so hash them along with the dimensions, uniform
+    // costs are left out so the tables cached before maps had costs still match
+    std::vector<int> key;
+    key.reserve(static_cast<size_t>(width * height * 2 + 2));
+    key.push_back(width);
+    key.push_back(height);
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            key.push_back(terrain->is_wall(row, col) ? 1 : 0);
+        }
+    }
+
+    if (uniformCost == false)
+    {
+        for (const float cost : grid->costs)
+        {
+            int bits;
+            std::memcpy(&bits, &cost, sizeof(bits));
+            key.push_back(bits);
+        }
+    }
+
+    return MurmurHash(key.data(), key.size() * sizeof(int));
+}
+
+std::string AStarPather::goal_bounds_filename(size_t hash)
+{
+    std::stringstream name;
+    name << std::hex << std::setw(sizeof(size_t) * 2) << std::setfill('0') << hash << ".bin";
+
+    return name.str();
+}
+
+bool AStarPather::load_goal_bounds(const std::filesystem::path &file, size_t hash)
+{
+    std::ifstream stream(file, std::ios::binary);
+
+    if (!stream)
+    {
+        return false;
+    }
+
+    CacheHeader header;
+    stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    if (!stream || header.magic != cacheMagic || header.version != cacheVersion ||
+        header.width != width || header.height != height || header.hash != hash)
+    {
+        std::cout << "Ignoring stale goal bounding cache " << file << std::endl;
+        return false;
+    }
+
+    stream.read(reinterpret_cast<char *>(goalBounds.data()), goalBounds.size() * sizeof(BoundingBox));
+
+    if (!stream)
+    {
+        std::cout << "Goal bounding cache " << file << " is truncated" << std::endl;
+        std::fill(goalBounds.begin(), goalBounds.end(), BoundingBox { emptyMin, emptyMax, emptyMin, emptyMax });
+        return false;
+    }
+
+    return true;
+}
+
+void AStarPather::save_goal_bounds(const std::filesystem::path &file, size_t hash) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(file.parent_path(), error);
+
+    std::ofstream stream(file, std::ios::binary);
+
+    if (!stream)
+    {
+        std::cout << "Unable to write goal bounding cache " << file << std::endl;
+        return;
+    }
+
+    const CacheHeader header { cacheMagic, cacheVersion, width, height, static_cast<uint64_t>(hash) };
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(goalBounds.data()), goalBounds.size() * sizeof(BoundingBox));
+}
@@ -0,0 +1,479 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+#include "P2_SearchKernel.h"
+#include "Misc/Stopwatch.h"
+#include <tuple>
+
+/*
+    Hierarchical pathfinding (HPA*, Botea, Mueller and Schaeffer).
+
+    The grid is split into clusterSize x clusterSize clusters.  Wherever two neighboring
+    clusters share a run of open cells along their border, one or two entrances are placed
+    in that run, each a pair of abstract nodes facing each other across the border.  Every
+    pair of entrance nodes in the same cluster is then linked by its shortest distance
+    inside that cluster, all on MAP_CHANGE.  Toggling a wall only searches the clusters
+    around it again.
+
+    A query links the start and goal into the entrances of their own clusters, searches
+    the small abstract graph, and only then turns the abstract path back into cells, one
+    leg at a time.  When the request has a deadline the legs are handed out as they're
+    refined, so the agent can start walking while the rest of the path is still abstract.
+*/
+
+namespace
+{
+    const int clusterSize = 10;
+
+    // runs of open border cells at least this long get an entrance at both ends instead of one in the middle
+    const int maxSingleEntranceRun = 6;
+
+    const float unreachable = std::numeric_limits<float>::infinity();
+}
+
+void AStarPather::build_abstract_graph(int changedCell)
+{
+    clustersWide = (width + clusterSize - 1) / clusterSize;
+    const int clustersHigh = (height + clusterSize - 1) / clusterSize;
+    const size_t numClusters = static_cast<size_t>(clustersWide * clustersHigh);
+
+    // after a single cell changes, only its own cluster's distances can move, and only the borders it sits on can
+    // gain or lose entrances, so every other cluster keeps its links, remembered by cell since the nodes are renumbered
+    std::vector<char> research(numClusters, 1);
+    std::vector<std::tuple<int, int, float>> kept;
+
+    if (changedCell != -1 && clusterNodes.size() == numClusters)
+    {
+        std::fill(research.begin(), research.end(), 0);
+        research[cluster_of(changedCell)] = 1;
+
+        const int row = changedCell / width;
+        const int col = changedCell - row * width;
+
+        for (int d = 0; d < NORTH_EAST; ++d)
+        {
+            const int r = row + rowOffset[d];
+            const int c = col + colOffset[d];
+
+            if (r >= 0 && r < height && c >= 0 && c < width)
+            {
+                research[cluster_of(r * width + c)] = 1;
+            }
+        }
+
+        for (size_t cluster = 0; cluster < numClusters; ++cluster)
+        {
+            if (research[cluster] == 1)
+            {
+                continue;
+            }
+
+            for (const int node : clusterNodes[cluster])
+            {
+                for (const auto &edge : abstractEdges[node])
+                {
+                    if (edge.to > node && cluster_of(abstractCells[edge.to]) == static_cast<int>(cluster))
+                    {
+                        kept.emplace_back(abstractCells[node], abstractCells[edge.to], edge.cost);
+                    }
+                }
+            }
+        }
+    }
+
+    abstractCells.clear();
+    abstractEdges.clear();
+    clusterNodes.assign(numClusters, std::vector<int> {});
+
+    std::vector<int> cellToNode(static_cast<size_t>(width * height), -1);
+
+    auto node_for = [this, &cellToNode](int cell)
+    {
+        if (cellToNode[cell] == -1)
+        {
+            cellToNode[cell] = static_cast<int>(abstractCells.size());
+            abstractCells.push_back(cell);
+            abstractEdges.emplace_back();
+            clusterNodes[cluster_of(cell)].push_back(cellToNode[cell]);
+        }
+
+        return cellToNode[cell];
+    };
+
+    auto link = [this](int node0, int node1, float cost)
+    {
+        abstractEdges[node0].push_back(AbstractEdge { node1, cost });
+        abstractEdges[node1].push_back(AbstractEdge { node0, cost });
+    };
+
+    // walks one border segment, first is the cell on the near side, along steps down the border
+    // and across is the direction that steps over it
+    auto add_entrances = [&](int first, int along, int length, int across)
+    {
+        const int step = rowOffset[across] * width + colOffset[across];
+        int runStart = -1;
+
+        for (int i = 0; i <= length; ++i)
+        {
+            const bool open = i < length && (neighbors[first + i * along] & (1 << across)) != 0;
+
+            if (open == true && runStart == -1)
+            {
+                runStart = i;
+            }
+            else if (open == false && runStart != -1)
+            {
+                const int runEnd = i - 1;
+
+                if (runEnd - runStart + 1 < maxSingleEntranceRun)
+                {
+                    const int cell = first + ((runStart + runEnd) / 2) * along;
+                    link(node_for(cell), node_for(cell + step), edgeCosts[cell * NUM_DIRECTIONS + across]);
+                }
+                else
+                {
+                    const int cell0 = first + runStart * along;
+                    const int cell1 = first + runEnd * along;
+                    link(node_for(cell0), node_for(cell0 + step), edgeCosts[cell0 * NUM_DIRECTIONS + across]);
+                    link(node_for(cell1), node_for(cell1 + step), edgeCosts[cell1 * NUM_DIRECTIONS + across]);
+                }
+
+                runStart = -1;
+            }
+        }
+    };
+
+    for (int col = clusterSize; col < width; col += clusterSize)
+    {
+        for (int row = 0; row < height; row += clusterSize)
+        {
+            add_entrances(row * width + col - 1, width, std::min(clusterSize, height - row), EAST);
+        }
+    }
+
+    for (int row = clusterSize; row < height; row += clusterSize)
+    {
+        for (int col = 0; col < width; col += clusterSize)
+        {
+            add_entrances((row - 1) * width + col, 1, std::min(clusterSize, width - col), NORTH);
+        }
+    }
+
+    for (const auto &[cell0, cell1, cost] : kept)
+    {
+        link(cellToNode[cell0], cellToNode[cell1], cost);
+    }
+
+    // every pair of entrances that can reach each other without leaving their cluster
+    for (size_t cluster = 0; cluster < clusterNodes.size(); ++cluster)
+    {
+        if (research[cluster] == 0)
+        {
+            continue;
+        }
+
+        const auto &nodes = clusterNodes[cluster];
+        const BoundingBox bounds = cluster_bounds(static_cast<int>(cluster), static_cast<int>(cluster));
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            for (size_t j = i + 1; j < nodes.size(); ++j)
+            {
+                const int to = abstractCells[nodes[j]];
+
+                if (search_within(search, abstractCells[nodes[i]], to, bounds) == true)
+                {
+                    link(nodes[i], nodes[j], search.nodes[to].given);
+                }
+            }
+        }
+    }
+}
+
+int AStarPather::cluster_of(int cell) const
+{
+    const int row = cell / width;
+    const int col = cell - row * width;
+
+    return (row / clusterSize) * clustersWide + col / clusterSize;
+}
+
+AStarPather::BoundingBox AStarPather::cluster_bounds(int cluster0, int cluster1) const
+{
+    const int row0 = cluster0 / clustersWide;
+    const int col0 = cluster0 % clustersWide;
+    const int row1 = cluster1 / clustersWide;
+    const int col1 = cluster1 % clustersWide;
+
+    const int minRow = std::min(row0, row1) * clusterSize;
+    const int maxRow = std::min((std::max(row0, row1) + 1) * clusterSize, height) - 1;
+    const int minCol = std::min(col0, col1) * clusterSize;
+    const int maxCol = std::min((std::max(col0, col1) + 1) * clusterSize, width) - 1;
+
+    return BoundingBox { static_cast<short>(minRow), static_cast<short>(maxRow), static_cast<short>(minCol), static_cast<short>(maxCol) };
+}
+
+bool AStarPather::search_within(SearchState &state, int from, int to, const BoundingBox &bounds) const
+{
+    if (uniformCost == true)
+    {
+        return search_box<SpecializedSearchPolicy<Method::ASTAR, Heuristic::OCTILE, false, false, false>>(state, from, to, bounds);
+    }
+
+    return search_box<SpecializedSearchPolicy<Method::ASTAR, Heuristic::OCTILE, false, false, true>>(state, from, to, bounds);
+}
+
+template <typename Policy>
+bool AStarPather::search_box(SearchState &state, int from, int to, const BoundingBox &bounds) const
+{
+    // plain octile A*, kept inside the box, retargets the state at to
+    static const PathRequest::Settings settings { Method::ASTAR, Heuristic::OCTILE, 1.0f, Weighting::STATIC, false, false, false, false, false };
+
+    state.goalIndex = to;
+    state.goalPos = GridPos { to / width, to % width };
+    state.begin(from);
+
+    while (state.openList.empty() == false)
+    {
+        const int current = state.pop();
+
+        if (current == to)
+        {
+            return true;
+        }
+
+        state.nodes[current].state = NodeState::CLOSED;
+
+        const int row = current / width;
+        const int col = current - row * width;
+        const unsigned char mask = neighbors[current];
+
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            const int r = row + rowOffset[d];
+            const int c = col + colOffset[d];
+
+            if ((mask & (1 << d)) != 0 && r >= bounds.minRow && r <= bounds.maxRow && c >= bounds.minCol && c <= bounds.maxCol)
+            {
+                relax<Policy>(state, current, r * width + c, move_cost<Policy>(current, d), settings);
+            }
+        }
+    }
+
+    return false;
+}
+
+bool AStarPather::plan_abstract_path(SearchState &state, int startIndex) const
+{
+    auto &abstract = state.abstract;
+    abstract.path.clear();
+    abstract.refined = 0;
+
+    const int goal = state.goalIndex;
+    const int startCluster = cluster_of(startIndex);
+    const int goalCluster = cluster_of(goal);
+
+    // a goal in the same or a touching cluster is searched for directly, routing such short paths
+    // through the entrances would make them needlessly long
+    const bool nearby = std::abs(startCluster / clustersWide - goalCluster / clustersWide) <= 1 &&
+        std::abs(startCluster % clustersWide - goalCluster % clustersWide) <= 1;
+
+    if (nearby == true && search_within(state, startIndex, goal, cluster_bounds(startCluster, goalCluster)) == true)
+    {
+        abstract.path.push_back(startIndex);
+
+        if (goal != startIndex)
+        {
+            abstract.path.push_back(goal);
+        }
+
+        return true;
+    }
+
+    const size_t numNodes = abstractCells.size();
+    const int goalNode = static_cast<int>(numNodes);
+
+    abstract.given.assign(numNodes + 1, unreachable);
+    abstract.goalCost.assign(numNodes, unreachable);
+    abstract.parent.assign(numNodes + 1, -1);
+    abstract.closed.assign(numNodes + 1, 0);
+    abstract.open.clear();
+
+    const GridPos goalPos { goal / width, goal % width };
+
+    auto octile = [this, &goalPos](int cell)
+    {
+        const float dRow = static_cast<float>(std::abs(cell / width - goalPos.row));
+        const float dCol = static_cast<float>(std::abs(cell % width - goalPos.col));
+
+        return (std::min(dRow, dCol) * (moveCost[NORTH_EAST] - 1.0f) + std::max(dRow, dCol)) * costFloor;
+    };
+
+    auto push = [&abstract](float total, int node)
+    {
+        abstract.open.emplace_back(total, node);
+        std::push_heap(abstract.open.begin(), abstract.open.end(), std::greater<std::pair<float, int>> {});
+    };
+
+    // temporarily link the goal into its cluster's entrances, as one extra node past the real ones
+    const BoundingBox goalBounds = cluster_bounds(goalCluster, goalCluster);
+
+    for (const int node : clusterNodes[goalCluster])
+    {
+        if (search_within(state, abstractCells[node], goal, goalBounds) == true)
+        {
+            abstract.goalCost[node] = state.nodes[goal].given;
+        }
+    }
+
+    const BoundingBox startBounds = cluster_bounds(startCluster, startCluster);
+
+    for (const int node : clusterNodes[startCluster])
+    {
+        const int cell = abstractCells[node];
+
+        if (search_within(state, startIndex, cell, startBounds) == true)
+        {
+            abstract.given[node] = state.nodes[cell].given;
+            push(abstract.given[node] + octile(cell), node);
+        }
+    }
+
+    while (abstract.open.empty() == false)
+    {
+        std::pop_heap(abstract.open.begin(), abstract.open.end(), std::greater<std::pair<float, int>> {});
+        const int current = abstract.open.back().second;
+        abstract.open.pop_back();
+
+        if (abstract.closed[current] != 0)
+        {
+            continue;
+        }
+
+        abstract.closed[current] = 1;
+
+        if (current == goalNode)
+        {
+            break;
+        }
+
+        auto relax_node = [&](int next, float given, float estimate)
+        {
+            if (abstract.closed[next] == 0 && given < abstract.given[next])
+            {
+                abstract.given[next] = given;
+                abstract.parent[next] = current;
+                push(given + estimate, next);
+            }
+        };
+
+        if (abstract.goalCost[current] != unreachable)
+        {
+            relax_node(goalNode, abstract.given[current] + abstract.goalCost[current], 0.0f);
+        }
+
+        for (const auto &edge : abstractEdges[current])
+        {
+            relax_node(edge.to, abstract.given[current] + edge.cost, octile(abstractCells[edge.to]));
+        }
+    }
+
+    if (abstract.closed[goalNode] == 0)
+    {
+        return false;
+    }
+
+    // the parents run goal to start, the legs are refined start first
+    abstract.path.push_back(goal);
+
+    for (int node = abstract.parent[goalNode]; node != -1; node = abstract.parent[node])
+    {
+        if (abstractCells[node] != abstract.path.back())
+        {
+            abstract.path.push_back(abstractCells[node]);
+        }
+    }
+
+    if (startIndex != abstract.path.back())
+    {
+        abstract.path.push_back(startIndex);
+    }
+
+    std::reverse(abstract.path.begin(), abstract.path.end());
+
+    return true;
+}
+
+PathResult AStarPather::refine_abstract_path(SearchState &state, const PathRequest::Settings &settings,
+    const std::chrono::high_resolution_clock::time_point *stopAt) const
+{
+    auto &abstract = state.abstract;
+    auto &cells = abstract.cells;
+    const bool first = abstract.refined == 0;
+
+    // later pieces pick up after the cell the previous one ended on
+    cells.clear();
+
+    if (first == true)
+    {
+        cells.push_back(abstract.path.front());
+    }
+
+    while (abstract.refined + 1 < abstract.path.size())
+    {
+        if (refine_leg(state, abstract.path[abstract.refined], abstract.path[abstract.refined + 1], cells) == false)
+        {
+            return PathResult::IMPOSSIBLE;
+        }
+
+        ++abstract.refined;
+
+        if (settings.debugColoring == true)
+        {
+            const int entrance = abstract.path[abstract.refined];
+            terrain->set_color(entrance / width, entrance % width, Colors::Blue);
+        }
+
+        if (settings.singleStep == true || (stopAt != nullptr && Stopwatch::now() >= *stopAt))
+        {
+            break;
+        }
+    }
+
+    const bool done = abstract.refined + 1 >= abstract.path.size();
+    state.partial = first == false || done == false;
+    state.cellPath.assign(cells.rbegin(), cells.rend());
+
+    return done == true ? PathResult::COMPLETE : PathResult::PROCESSING;
+}
+
+bool AStarPather::refine_leg(SearchState &state, int from, int to, std::vector<int> &cells) const
+{
+    const int fromCluster = cluster_of(from);
+    const int toCluster = cluster_of(to);
+
+    // between entrances the abstract edges are single cardinal steps over the border, anything else
+    // is searched for again, over both clusters for a direct path to a nearby goal
+    const int step = direction_step(from, to);
+
+    if (fromCluster != toCluster && step == to - from && (step == 1 || step == -1 || step == width || step == -width))
+    {
+        cells.push_back(to);
+        return true;
+    }
+
+    if (search_within(state, from, to, cluster_bounds(fromCluster, toCluster)) == false)
+    {
+        return false;
+    }
+
+    const size_t legBegin = cells.size();
+
+    for (int index = to; index != from; index = state.nodes[index].parent)
+    {
+        cells.push_back(index);
+    }
+
+    std::reverse(cells.begin() + legBegin, cells.end());
+
+    return true;
+}
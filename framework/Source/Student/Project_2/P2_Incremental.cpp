@@ -0,0 +1,614 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+#include "Misc/Stopwatch.h"
+
+/*
+    Moving target D* Lite (Sun, Yeoh and Koenig), LPA* searching forward from the owner.
+
+    The search is rooted where its owner stands and searches toward the goal, keeping every g
+    and rhs value between requests.  When the goal moves, the change in the heuristic is folded
+    into km instead of rekeying the open list, so a chase replan only expands the cells whose
+    distances actually changed.  When the owner moves, the root moves with it: every distance
+    in the subtree hanging from its new cell ran through that cell, so those all drop by the
+    same amount and stay settled, and only the cells left behind are reset and given whatever
+    way in the kept ones offer.  A toggled wall is repaired the same way, the cells around it
+    are updated in on_wall_change and the next request settles the rest.
+
+    Costs are rounded to fixed point so they add exactly, a cell whose route ends at the target
+    then ties with it on key0 rather than landing a rounding error either side, and key1 breaks
+    the tie the way LPA* expects.
+
+    Every chasing agent keeps a search of its own, found by its request, so two chasers never
+    start each other's over.  There are a handful of them, and past that a new chaser takes the
+    one used longest ago.
+
+    Heuristic, weight and method are ignored, this is always an optimal octile search, scaled by the
+    cheapest terrain cost so it stays a lower bound on maps with costs.
+*/
+
+namespace
+{
+    // a power of two, so scaling a cost is exact and only the rounding to a whole number moves it
+    const int fixedScale = 4096;
+    const int unreachable = std::numeric_limits<int>::max();
+
+    // reading the clock isn't free, so only check it every so often
+    const unsigned deadlineCheckMask = 63;
+
+    // each one holds a node per cell, so only this many chasers keep their search at once
+    const size_t maxIncrementalSearches = 8;
+}
+
+PathResult AStarPather::run_incremental(PathRequest &request, const std::chrono::high_resolution_clock::time_point *stopAt)
+{
+    IncrementalSearch &state = incremental_search_for(request);
+
+    if (request.newRequest == true)
+    {
+        search.partial = false;
+        search.expanded = 0;
+
+        const GridPos start = terrain->get_grid_position(request.start);
+        const GridPos goal = terrain->get_grid_position(request.goal);
+
+        if (terrain->is_valid_grid_position(start) == false || terrain->is_valid_grid_position(goal) == false ||
+            terrain->is_wall(start) == true || terrain->is_wall(goal) == true)
+        {
+            return PathResult::IMPOSSIBLE;
+        }
+
+        const int startIndex = start.row * width + start.col;
+        const int goalIndex = goal.row * width + goal.col;
+
+        if (components[startIndex] != components[goalIndex])
+        {
+            return PathResult::IMPOSSIBLE;
+        }
+
+        const int previousTarget = state.target;
+        state.target = goalIndex;
+
+        // moving the root rekeys everything queued, otherwise the goal's shift is added to km, octile is consistent
+        // so every queued key stays a lower bound with it
+        if (state.owner != &request || state.root == -1 ||
+            (startIndex != state.root && reroot_incremental(state, startIndex) == false))
+        {
+            state.owner = &request;
+            state.begin(startIndex, goalIndex);
+            key_incremental(state, startIndex);
+            state.push(startIndex);
+        }
+        else if (startIndex == state.root && goalIndex != previousTarget)
+        {
+            state.km += estimate_incremental(previousTarget, goalIndex);
+        }
+    }
+
+    const auto result = solve_incremental(state, request.settings, stopAt);
+
+    // the root is the owner, so a settled target always leads back to it
+    if (result == PathResult::COMPLETE && extract_incremental(state) == false)
+    {
+        return PathResult::IMPOSSIBLE;
+    }
+
+    return result;
+}
+
+PathResult AStarPather::solve_incremental(IncrementalSearch &state, const PathRequest::Settings &settings,
+    const std::chrono::high_resolution_clock::time_point *stopAt)
+{
+    while (state.openList.empty() == false)
+    {
+        const int current = state.openList.front();
+        IncrementalNode &node = state.nodes[current];
+
+        // a settled target isn't queued, so its key can be refreshed in place, and once nothing comes before it
+        // every cell that could still shorten its route has been seen to
+        IncrementalNode &target = state.touch(state.target);
+
+        if (target.g == target.rhs)
+        {
+            key_incremental(state, state.target);
+
+            if (node.precedes(target) == false)
+            {
+                break;
+            }
+        }
+
+        // the key was made before km last grew, refresh it and look again
+        const IncrementalNode queued = node;
+        key_incremental(state, current);
+
+        if (queued.precedes(node) == true)
+        {
+            state.update(current);
+            continue;
+        }
+
+        state.remove(current);
+
+        const int row = current / width;
+        const int col = current - row * width;
+        const unsigned char mask = neighbors[current];
+
+        if (node.g > node.rhs)
+        {
+            node.g = node.rhs;
+
+            for (int d = 0; d < NUM_DIRECTIONS; ++d)
+            {
+                const int next = (row + rowOffset[d]) * width + col + colOffset[d];
+
+                if ((mask & (1 << d)) == 0 || next == state.root)
+                {
+                    continue;
+                }
+
+                IncrementalNode &neighbor = state.touch(next);
+                const int given = node.g + cost_incremental(current, d);
+
+                if (given < neighbor.rhs)
+                {
+                    neighbor.rhs = given;
+                    neighbor.parent = current;
+                    queue_incremental(state, next);
+
+                    if (settings.debugColoring == true)
+                    {
+                        terrain->set_color(next / width, next % width, Colors::Blue);
+                    }
+                }
+            }
+        }
+        else
+        {
+            node.g = unreachable;
+
+            for (int d = 0; d < NUM_DIRECTIONS; ++d)
+            {
+                const int next = (row + rowOffset[d]) * width + col + colOffset[d];
+
+                if ((mask & (1 << d)) != 0 && state.touch(next).parent == current)
+                {
+                    update_incremental(state, next);
+                }
+            }
+
+            update_incremental(state, current);
+        }
+
+        ++search.expanded;
+
+        if (settings.debugColoring == true)
+        {
+            terrain->set_color(row, col, Colors::Yellow);
+        }
+
+        if (settings.singleStep == true)
+        {
+            return PathResult::PROCESSING;
+        }
+
+        if (stopAt != nullptr && (search.expanded & deadlineCheckMask) == 0 && Stopwatch::now() >= *stopAt)
+        {
+            return PathResult::PROCESSING;
+        }
+    }
+
+    return state.touch(state.target).g == unreachable ? PathResult::IMPOSSIBLE : PathResult::COMPLETE;
+}
+
+void AStarPather::update_incremental(IncrementalSearch &state, int index)
+{
+    IncrementalNode &node = state.touch(index);
+
+    // recompute the best way in, keeping the current parent on ties so settled routes don't flicker
+    if (index != state.root)
+    {
+        const int row = index / width;
+        const int col = index - row * width;
+        const unsigned char mask = neighbors[index];
+
+        int best = unreachable;
+        int parent = -1;
+
+        for (int d = 0; d < NUM_DIRECTIONS; ++d)
+        {
+            if ((mask & (1 << d)) == 0)
+            {
+                continue;
+            }
+
+            const int previous = (row + rowOffset[d]) * width + col + colOffset[d];
+
+            if (state.g(previous) == unreachable)
+            {
+                continue;
+            }
+
+            const int given = state.g(previous) + cost_incremental(index, d);
+
+            if (given < best || (given == best && previous == node.parent))
+            {
+                best = given;
+                parent = previous;
+            }
+        }
+
+        node.rhs = best;
+        node.parent = parent;
+    }
+
+    queue_incremental(state, index);
+}
+
+void AStarPather::queue_incremental(IncrementalSearch &state, int index)
+{
+    IncrementalNode &node = state.nodes[index];
+
+    // only inconsistent cells belong on the open list
+    if (node.g != node.rhs)
+    {
+        key_incremental(state, index);
+
+        if (node.heapIndex == -1)
+        {
+            state.push(index);
+        }
+        else
+        {
+            state.update(index);
+        }
+    }
+    else if (node.heapIndex != -1)
+    {
+        state.remove(index);
+    }
+}
+
+void AStarPather::key_incremental(IncrementalSearch &state, int index)
+{
+    IncrementalNode &node = state.touch(index);
+
+    node.key1 = std::min(node.g, node.rhs);
+    node.key0 = node.key1 == unreachable ? unreachable : node.key1 + estimate_incremental(index, state.target) + state.km;
+}
+
+bool AStarPather::reroot_incremental(IncrementalSearch &state, int index)
+{
+    using Branch = IncrementalSearch::Branch;
+
+    // nothing was found past the owner's cell, so there's nothing to keep either
+    const int offset = state.touch(index).rhs;
+
+    if (offset == unreachable)
+    {
+        return false;
+    }
+
+    // sort every touched cell by whether its parents lead to the new root, following them up until they reach a cell
+    // already sorted, a chain that ends anywhere else or loops back on itself was left behind
+    auto &branches = state.branches;
+    branches[index] = Branch::KEPT;
+
+    for (const int cell : state.touched)
+    {
+        if (branches[cell] != Branch::UNSORTED)
+        {
+            continue;
+        }
+
+        state.chain.clear();
+        int ancestor = cell;
+
+        while (ancestor != -1 && state.nodes[ancestor].generation == state.generation && branches[ancestor] == Branch::UNSORTED)
+        {
+            branches[ancestor] = Branch::FOLLOWING;
+            state.chain.push_back(ancestor);
+            ancestor = state.nodes[ancestor].parent;
+        }
+
+        const Branch branch = ancestor != -1 && branches[ancestor] == Branch::KEPT ? Branch::KEPT : Branch::DROPPED;
+
+        for (const int link : state.chain)
+        {
+            branches[link] = branch;
+        }
+    }
+
+    // every key is made over, so km starts again too
+    state.openList.clear();
+    state.dropped.clear();
+    state.root = index;
+    state.km = 0;
+    state.nodes[index].parent = -1;
+
+    size_t numKept = 0;
+
+    for (const int cell : state.touched)
+    {
+        IncrementalNode &node = state.nodes[cell];
+        node.heapIndex = -1;
+
+        if (branches[cell] == Branch::KEPT)
+        {
+            // the routes to these all ran through the new root, so each is shorter by exactly its distance
+            node.g = node.g == unreachable ? unreachable : node.g - offset;
+            node.rhs = node.rhs == unreachable ? unreachable : node.rhs - offset;
+            state.touched[numKept++] = cell;
+
+            if (node.g != node.rhs)
+            {
+                key_incremental(state, cell);
+                node.heapIndex = static_cast<int>(state.openList.size());
+                state.openList.push_back(cell);
+            }
+        }
+        else
+        {
+            node.g = unreachable;
+            node.rhs = unreachable;
+            node.parent = -1;
+            state.dropped.push_back(cell);
+        }
+
+        branches[cell] = Branch::UNSORTED;
+    }
+
+    state.touched.resize(numKept);
+
+    // the kept cells still queued only need ordering once, rather than a push each
+    for (int slot = static_cast<int>(state.openList.size()) / 2 - 1; slot >= 0; --slot)
+    {
+        state.heap_down(slot);
+    }
+
+    // the cells left behind are only worth anything through the kept ones now, and those that aren't go back to
+    // untouched so the next move doesn't look at them again
+    for (const int cell : state.dropped)
+    {
+        update_incremental(state, cell);
+
+        if (state.nodes[cell].rhs == unreachable)
+        {
+            state.nodes[cell].generation = state.generation - 1;
+        }
+        else
+        {
+            state.touched.push_back(cell);
+        }
+    }
+
+    return true;
+}
+
+int AStarPather::estimate_incremental(int from, int to) const
+{
+    const int dRow = std::abs(from / width - to / width);
+    const int dCol = std::abs(from % width - to % width);
+
+    // rounded down, while every move rounds to nearest from at least as much, so it stays a consistent lower bound
+    const int cardinal = static_cast<int>(costFloor * fixedScale);
+    const int diagonal = static_cast<int>(moveCost[NORTH_EAST] * costFloor * fixedScale);
+
+    return std::min(dRow, dCol) * diagonal + (std::max(dRow, dCol) - std::min(dRow, dCol)) * cardinal;
+}
+
+int AStarPather::cost_incremental(int index, int direction) const
+{
+    return static_cast<int>(std::lround(edgeCosts[index * NUM_DIRECTIONS + direction] * fixedScale));
+}
+
+bool AStarPather::extract_incremental(const IncrementalSearch &state)
+{
+    auto &cellPath = search.cellPath;
+    cellPath.clear();
+
+    // follow the parents back from the goal, goal to start like a search leaves behind
+    for (int index = state.target; index != -1; index = state.nodes[index].parent)
+    {
+        cellPath.push_back(index);
+
+        if (index == state.root)
+        {
+            return true;
+        }
+
+        if (cellPath.size() > state.nodes.size())
+        {
+            break;
+        }
+    }
+
+    return false;
+}
+
+AStarPather::IncrementalSearch &AStarPather::incremental_search_for(const PathRequest &request)
+{
+    IncrementalSearch *oldest = nullptr;
+
+    for (auto &state : incrementalSearches)
+    {
+        if (state.owner == &request)
+        {
+            oldest = &state;
+            break;
+        }
+
+        if (oldest == nullptr || state.lastUsed < oldest->lastUsed)
+        {
+            oldest = &state;
+        }
+    }
+
+    // a request without one of its own gets a new search, or the oldest once there are enough,
+    // either way the owner won't match so run_incremental starts it over
+    if (oldest == nullptr || (oldest->owner != &request && incrementalSearches.size() < maxIncrementalSearches))
+    {
+        incrementalSearches.emplace_back();
+        oldest = &incrementalSearches.back();
+        oldest->resize(static_cast<size_t>(width * height));
+    }
+
+    oldest->lastUsed = ++incrementalClock;
+    return *oldest;
+}
+
+bool AStarPather::IncrementalNode::precedes(const IncrementalNode &other) const
+{
+    return key0 < other.key0 || (key0 == other.key0 && key1 < other.key1);
+}
+
+void AStarPather::IncrementalSearch::resize(size_t numCells)
+{
+    nodes.assign(numCells, IncrementalNode {});
+    openList.clear();
+    openList.reserve(numCells);
+    touched.clear();
+    touched.reserve(numCells);
+    branches.assign(numCells, Branch::UNSORTED);
+    chain.clear();
+    chain.reserve(numCells);
+    dropped.clear();
+    dropped.reserve(numCells);
+
+    generation = 0;
+    root = -1;
+    target = -1;
+    km = 0;
+    owner = nullptr;
+    lastUsed = 0;
+}
+
+void AStarPather::IncrementalSearch::begin(int rootIndex, int targetIndex)
+{
+    if (++generation == 0)
+    {
+        for (auto &node : nodes)
+        {
+            node.generation = 0;
+        }
+
+        generation = 1;
+    }
+
+    openList.clear();
+    touched.clear();
+    root = rootIndex;
+    target = targetIndex;
+    km = 0;
+
+    touch(rootIndex).rhs = 0;
+}
+
+AStarPather::IncrementalNode &AStarPather::IncrementalSearch::touch(int index)
+{
+    IncrementalNode &node = nodes[index];
+
+    if (node.generation != generation)
+    {
+        node.generation = generation;
+        node.g = unreachable;
+        node.rhs = unreachable;
+        node.parent = -1;
+        node.heapIndex = -1;
+        touched.push_back(index);
+    }
+
+    return node;
+}
+
+int AStarPather::IncrementalSearch::g(int index) const
+{
+    const IncrementalNode &node = nodes[index];
+
+    return node.generation == generation ? node.g : unreachable;
+}
+
+void AStarPather::IncrementalSearch::push(int index)
+{
+    IncrementalNode &node = nodes[index];
+    node.heapIndex = static_cast<int>(openList.size());
+    openList.push_back(index);
+    heap_up(node.heapIndex);
+}
+
+void AStarPather::IncrementalSearch::remove(int index)
+{
+    const int slot = nodes[index].heapIndex;
+    const int last = openList.back();
+    openList.pop_back();
+    nodes[index].heapIndex = -1;
+
+    if (last != index)
+    {
+        openList[slot] = last;
+        nodes[last].heapIndex = slot;
+        update(last);
+    }
+}
+
+void AStarPather::IncrementalSearch::update(int index)
+{
+    // keys move both ways here, unlike the A* open list
+    heap_up(nodes[index].heapIndex);
+    heap_down(nodes[index].heapIndex);
+}
+
+void AStarPather::IncrementalSearch::heap_up(int slot)
+{
+    const int index = openList[slot];
+
+    while (slot > 0)
+    {
+        const int parentSlot = (slot - 1) >> 1;
+        const int parent = openList[parentSlot];
+
+        if (nodes[index].precedes(nodes[parent]) == false)
+        {
+            break;
+        }
+
+        openList[slot] = parent;
+        nodes[parent].heapIndex = slot;
+        slot = parentSlot;
+    }
+
+    openList[slot] = index;
+    nodes[index].heapIndex = slot;
+}
+
+void AStarPather::IncrementalSearch::heap_down(int slot)
+{
+    const int size = static_cast<int>(openList.size());
+    const int index = openList[slot];
+
+    while (true)
+    {
+        int child = (slot << 1) + 1;
+
+        if (child >= size)
+        {
+            break;
+        }
+
+        if (child + 1 < size && nodes[openList[child + 1]].precedes(nodes[openList[child]]) == true)
+        {
+            ++child;
+        }
+
+        if (nodes[openList[child]].precedes(nodes[index]) == false)
+        {
+            break;
+        }
+
+        openList[slot] = openList[child];
+        nodes[openList[slot]].heapIndex = slot;
+        slot = child;
+    }
+
+    openList[slot] = index;
+    nodes[index].heapIndex = slot;
+}
@@ -0,0 +1,222 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+#include "P2_SearchKernel.h"
+
+/*
+    JPS+ (Rabin, Game AI Pro 2) with the no corner cutting movement rule.
+
+    On map change every open cell stores, per direction, how far it can travel before
+    reaching a jump point (positive) or a wall (zero or negative).  The search then only
+    ever touches jump points, the goal, and the turning points needed to line up with it.
+*/
+
+namespace
+{
+    constexpr unsigned char bit(int direction)
+    {
+        return static_cast<unsigned char>(1 << direction);
+    }
+
+    // the cardinal components of each diagonal, indexed by direction - NORTH_EAST
+    const int diagonalRowDirection[] = { AStarPather::NORTH, AStarPather::SOUTH, AStarPather::SOUTH, AStarPather::NORTH };
+    const int diagonalColDirection[] = { AStarPather::EAST, AStarPather::EAST, AStarPather::WEST, AStarPather::WEST };
+
+    // directions worth searching given the direction a node was arrived from, the last entry is the start node
+    const unsigned char validDirections[AStarPather::NUM_DIRECTIONS + 1] =
+    {
+        bit(AStarPather::NORTH) | bit(AStarPather::EAST) | bit(AStarPather::WEST) | bit(AStarPather::NORTH_EAST) | bit(AStarPather::NORTH_WEST),
+        bit(AStarPather::EAST) | bit(AStarPather::NORTH) | bit(AStarPather::SOUTH) | bit(AStarPather::NORTH_EAST) | bit(AStarPather::SOUTH_EAST),
+        bit(AStarPather::SOUTH) | bit(AStarPather::EAST) | bit(AStarPather::WEST) | bit(AStarPather::SOUTH_EAST) | bit(AStarPather::SOUTH_WEST),
+        bit(AStarPather::WEST) | bit(AStarPather::NORTH) | bit(AStarPather::SOUTH) | bit(AStarPather::SOUTH_WEST) | bit(AStarPather::NORTH_WEST),
+        bit(AStarPather::NORTH_EAST) | bit(AStarPather::NORTH) | bit(AStarPather::EAST),
+        bit(AStarPather::SOUTH_EAST) | bit(AStarPather::SOUTH) | bit(AStarPather::EAST),
+        bit(AStarPather::SOUTH_WEST) | bit(AStarPather::SOUTH) | bit(AStarPather::WEST),
+        bit(AStarPather::NORTH_WEST) | bit(AStarPather::NORTH) | bit(AStarPather::WEST),
+        0xFF
+    };
+
+    // direction of travel from the sign of a row and column delta, indexed [row + 1][col + 1]
+    const int deltaDirection[3][3] =
+    {
+        { AStarPather::SOUTH_WEST, AStarPather::SOUTH, AStarPather::SOUTH_EAST },
+        { AStarPather::WEST, AStarPather::NUM_DIRECTIONS, AStarPather::EAST },
+        { AStarPather::NORTH_WEST, AStarPather::NORTH, AStarPather::NORTH_EAST }
+    };
+
+    int sign(int value)
+    {
+        return (value > 0) - (value < 0);
+    }
+}
+
+bool AStarPather::is_open(int row, int col) const
+{
+    return terrain->is_valid_grid_position(row, col) == true && terrain->is_wall(row, col) == false;
+}
+
+bool AStarPather::is_jump_point(int row, int col, int direction) const
+{
+    const int prevRow = row - rowOffset[direction];
+    const int prevCol = col - colOffset[direction];
+
+    if (is_open(row, col) == false || is_open(prevRow, prevCol) == false)
+    {
+        return false;
+    }
+
+    // a cell has a forced neighbor when a wall beside the previous cell ends here
+    for (int side : { (direction + 1) % 4, (direction + 3) % 4 })
+    {
+        if (is_open(row + rowOffset[side], col + colOffset[side]) == true &&
+            is_open(prevRow + rowOffset[side], prevCol + colOffset[side]) == false)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AStarPather::build_jump_distances()
+{
+    jumpDistances.assign(static_cast<size_t>(width * height * NUM_DIRECTIONS), 0);
+
+    // sweep against the direction of travel so the next cell along is always already solved,
+    // cardinals first since the diagonals are defined in terms of them
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        const int rowBegin = rowOffset[d] > 0 ? height - 1 : 0;
+        const int rowStep = rowOffset[d] > 0 ? -1 : 1;
+        const int colBegin = colOffset[d] > 0 ? width - 1 : 0;
+        const int colStep = colOffset[d] > 0 ? -1 : 1;
+
+        for (int row = rowBegin; row >= 0 && row < height; row += rowStep)
+        {
+            for (int col = colBegin; col >= 0 && col < width; col += colStep)
+            {
+                if (is_open(row, col) == false)
+                {
+                    continue;
+                }
+
+                const int nextRow = row + rowOffset[d];
+                const int nextCol = col + colOffset[d];
+                const int next = nextRow * width + nextCol;
+
+                short distance = 0;
+
+                if (d < NORTH_EAST)
+                {
+                    if (is_open(nextRow, nextCol) == false)
+                    {
+                        distance = 0;
+                    }
+                    else if (is_jump_point(nextRow, nextCol, d) == true)
+                    {
+                        distance = 1;
+                    }
+                    else
+                    {
+                        const short nextDistance = jumpDistances[next * NUM_DIRECTIONS + d];
+                        distance = nextDistance > 0 ? nextDistance + 1 : nextDistance - 1;
+                    }
+                }
+                else
+                {
+                    const int rowDirection = diagonalRowDirection[d - NORTH_EAST];
+                    const int colDirection = diagonalColDirection[d - NORTH_EAST];
+
+                    if (is_open(nextRow, nextCol) == false || is_open(nextRow, col) == false || is_open(row, nextCol) == false)
+                    {
+                        distance = 0;
+                    }
+                    else if (jumpDistances[next * NUM_DIRECTIONS + rowDirection] > 0 ||
+                        jumpDistances[next * NUM_DIRECTIONS + colDirection] > 0)
+                    {
+                        distance = 1;
+                    }
+                    else
+                    {
+                        const short nextDistance = jumpDistances[next * NUM_DIRECTIONS + d];
+                        distance = nextDistance > 0 ? nextDistance + 1 : nextDistance - 1;
+                    }
+                }
+
+                jumpDistances[(row * width + col) * NUM_DIRECTIONS + d] = distance;
+            }
+        }
+    }
+}
+
+AStarPather::Kernel AStarPather::jump_point_kernel(const PathRequest::Settings &settings) const
+{
+    return specialized_kernel<Method::JPS_PLUS>(settings, false);
+}
+
+template <typename Policy>
+void AStarPather::expand_jump_points(SearchState &state, int current, const PathRequest::Settings &settings) const
+{
+    const int row = current / width;
+    const int col = current - row * width;
+
+    int arrival = NUM_DIRECTIONS;
+    const int parent = state.nodes[current].parent;
+
+    if (parent != -1)
+    {
+        const int parentRow = parent / width;
+        const int parentCol = parent - parentRow * width;
+        arrival = deltaDirection[sign(row - parentRow) + 1][sign(col - parentCol) + 1];
+    }
+
+    const int rowDiff = state.goalPos.row - row;
+    const int colDiff = state.goalPos.col - col;
+    const short *distances = &jumpDistances[current * NUM_DIRECTIONS];
+    const unsigned char mask = validDirections[arrival];
+
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        if ((mask & bit(d)) == 0)
+        {
+            continue;
+        }
+
+        const int distance = distances[d];
+        const int reach = std::abs(distance);
+        int steps = 0;
+
+        if (d < NORTH_EAST)
+        {
+            // the goal sits directly ahead before any wall
+            if (rowOffset[d] == 0 && rowDiff == 0 && sign(colDiff) == colOffset[d] && std::abs(colDiff) <= reach)
+            {
+                steps = std::abs(colDiff);
+            }
+            else if (colOffset[d] == 0 && colDiff == 0 && sign(rowDiff) == rowOffset[d] && std::abs(rowDiff) <= reach)
+            {
+                steps = std::abs(rowDiff);
+            }
+        }
+        else if (sign(rowDiff) == rowOffset[d] && sign(colDiff) == colOffset[d] &&
+            (std::abs(rowDiff) <= reach || std::abs(colDiff) <= reach))
+        {
+            // the goal is in this quadrant, stop where it lines up on a row or column
+            steps = std::min(std::abs(rowDiff), std::abs(colDiff));
+        }
+
+        if (steps == 0 && distance > 0)
+        {
+            steps = distance;
+        }
+
+        if (steps > 0)
+        {
+            const int next = current + steps * (rowOffset[d] * width + colOffset[d]);
+            relax<Policy>(state, current, next, static_cast<float>(steps) * moveCost[d], settings);
+        }
+    }
+}
+
+// the runtime kernel in P2_Pathfinding.cpp expands through this one
+template void AStarPather::expand_jump_points<RuntimeSearchPolicy>(SearchState &state, int current,
+    const PathRequest::Settings &settings) const;
@@ -0,0 +1,83 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+
+/*
+    ALT heuristic, A* with landmarks and the triangle inequality (Goldberg and Harrelson).
+
+    For any landmark L, |d(L, goal) - d(L, n)| never overestimates d(n, goal), and the largest such
+    bound over a handful of landmarks is usually far tighter than any straight line estimate on
+    maps where walls force long detours.  Landmarks work best out at the edges of the map, so
+    they're picked by farthest point selection: each new one is the open cell farthest from all
+    the landmarks chosen so far, with cells none of them can reach counting as farthest of all
+    so every separate region gets one.
+
+    Distances come from the same backward Dijkstra the flow fields use.
+*/
+
+void AStarPather::build_landmarks()
+{
+    const int numCells = width * height;
+
+    landmarkDistances.assign(static_cast<size_t>(numCells * landmarkCount), 0.0f);
+
+    // distance from each cell to the nearest landmark chosen so far
+    std::vector<float> nearest(static_cast<size_t>(numCells), std::numeric_limits<float>::infinity());
+    FlowFieldCache::Field field;
+
+    int landmark = -1;
+
+    for (int cell = 0; cell < numCells && landmark == -1; ++cell)
+    {
+        if (terrain->is_wall(cell / width, cell % width) == false)
+        {
+            landmark = cell;
+        }
+    }
+
+    if (landmark == -1)
+    {
+        return;
+    }
+
+    // the first open cell is just a place to start from, the first landmark is the farthest cell from it
+    build_flow_field(landmark, field);
+
+    for (int cell = 0; cell < numCells; ++cell)
+    {
+        if (field.distance[cell] != std::numeric_limits<float>::infinity() && field.distance[cell] > field.distance[landmark])
+        {
+            landmark = cell;
+        }
+    }
+
+    for (int i = 0; i < landmarkCount; ++i)
+    {
+        build_flow_field(landmark, field);
+
+        int farthest = -1;
+
+        for (int cell = 0; cell < numCells; ++cell)
+        {
+            const float distance = field.distance[cell];
+
+            if (distance != std::numeric_limits<float>::infinity())
+            {
+                landmarkDistances[cell * landmarkCount + i] = distance;
+                nearest[cell] = std::min(nearest[cell], distance);
+            }
+
+            if (terrain->is_wall(cell / width, cell % width) == false && (farthest == -1 || nearest[cell] > nearest[farthest]))
+            {
+                farthest = cell;
+            }
+        }
+
+        // once every open cell is a landmark, the remaining slots stay zero and never tighten the bound
+        if (nearest[farthest] == 0.0f)
+        {
+            break;
+        }
+
+        landmark = farthest;
+    }
+}
@@ -0,0 +1,218 @@
+#include <pch.h>
+#include "P2_PathCache.h"
+
+PathCache::PathCache(size_t capacity) : capacity(capacity), hits(0), subPathHits(0), misses(0),
+    textLookups(std::numeric_limits<size_t>::max())
+{
+    lookup.reserve(capacity);
+    spareNodes.reserve(capacity);
+}
+
+bool PathCache::Key::operator==(const Key &rhs) const
+{
+    return map == rhs.map && start == rhs.start && goal == rhs.goal &&
+        method == rhs.method && heuristic == rhs.heuristic && weight == rhs.weight && weighting == rhs.weighting;
+}
+
+size_t PathCache::KeyHash::operator()(const Key &key) const
+{
+    // grids are at most 40 x 40, so the endpoints pack into a few bits each
+    size_t hash = key.map;
+    hash = hash * 31 + static_cast<size_t>(key.start.row * 64 + key.start.col);
+    hash = hash * 31 + static_cast<size_t>(key.goal.row * 64 + key.goal.col);
+    hash = hash * 31 + static_cast<size_t>(key.method);
+    hash = hash * 31 + static_cast<size_t>(key.heuristic);
+    hash = hash * 31 + std::hash<float>()(key.weight);
+    hash = hash * 31 + static_cast<size_t>(key.weighting);
+
+    return hash;
+}
+
+bool PathCache::find(const Key &key, int width, std::vector<int> &cells)
+{
+    const auto result = lookup.find(key);
+
+    if (result != lookup.end())
+    {
+        entries.splice(entries.begin(), entries, result->second);
+        cells = result->second->cells;
+
+        ++hits;
+        return true;
+    }
+
+    if (find_sub_path(key, width, cells) == true)
+    {
+        ++subPathHits;
+        return true;
+    }
+
+    ++misses;
+    return false;
+}
+
+void PathCache::insert(const Key &key, const std::vector<int> &cells)
+{
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    const auto result = lookup.find(key);
+
+    if (result != lookup.end())
+    {
+        result->second->cells = cells;
+        entries.splice(entries.begin(), entries, result->second);
+        return;
+    }
+
+    Lookup::node_type node;
+
+    if (entries.size() >= capacity)
+    {
+        // reuse the evicted entry's buffer and lookup node rather than allocating new ones
+        node = lookup.extract(entries.back().key);
+        entries.splice(entries.begin(), entries, std::prev(entries.end()));
+    }
+    else if (spareEntries.empty() == false)
+    {
+        // least recently used first, so requests repeated after a wall change tend to get back the buffers they filled
+        node = std::move(spareNodes.back());
+        spareNodes.pop_back();
+        entries.splice(entries.begin(), spareEntries, std::prev(spareEntries.end()));
+    }
+    else
+    {
+        entries.emplace_front();
+    }
+
+    entries.front().key = key;
+    entries.front().cells = cells;
+
+    if (node.empty() == true)
+    {
+        lookup.emplace(key, entries.begin());
+    }
+    else
+    {
+        node.key() = key;
+        node.mapped() = entries.begin();
+        lookup.insert(std::move(node));
+    }
+}
+
+void PathCache::clear()
+{
+    for (const auto &entry : entries)
+    {
+        spareNodes.push_back(lookup.extract(entry.key));
+    }
+
+    spareEntries.splice(spareEntries.end(), entries);
+}
+
+size_t PathCache::get_reserved_bytes() const
+{
+    size_t bytes = lookup.bucket_count() * sizeof(void *) + spareNodes.capacity() * sizeof(Lookup::node_type) +
+        (lookup.size() + spareNodes.size()) * sizeof(Lookup::value_type);
+
+    for (const auto *list : { &entries, &spareEntries })
+    {
+        for (const auto &entry : *list)
+        {
+            bytes += sizeof(Entry) + entry.cells.capacity() * sizeof(int);
+        }
+    }
+
+    return bytes;
+}
+
+size_t PathCache::get_hits() const
+{
+    return hits;
+}
+
+size_t PathCache::get_sub_path_hits() const
+{
+    return subPathHits;
+}
+
+size_t PathCache::get_misses() const
+{
+    return misses;
+}
+
+const std::wstring &PathCache::get_stats_text() const
+{
+    const size_t lookups = hits + subPathHits + misses;
+
+    if (lookups != textLookups)
+    {
+        statsText = std::to_wstring(hits) + L" hit, " + std::to_wstring(subPathHits) + L" sub, " + std::to_wstring(misses) + L" miss";
+        textLookups = lookups;
+    }
+
+    return statsText;
+}
+
+bool PathCache::find_sub_path(const Key &key, int width, std::vector<int> &cells)
+{
+    // any stretch of an optimal path is itself optimal, in either direction since every move is reversible,
+    // that doesn't hold for weighted or overestimating searches, for HPA*'s near optimal paths, or for Theta*'s
+    // paths, which only list their turning points
+    if (is_optimal(key) == false)
+    {
+        return false;
+    }
+
+    const int startCell = key.start.row * width + key.start.col;
+    const int goalCell = key.goal.row * width + key.goal.col;
+
+    for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+    {
+        const Key &other = entry->key;
+
+        if (other.map != key.map || other.method != key.method || other.heuristic != key.heuristic || other.weight != key.weight ||
+            other.weighting != key.weighting)
+        {
+            continue;
+        }
+
+        const auto &path = entry->cells;
+        const auto startPos = std::find(path.begin(), path.end(), startCell);
+
+        if (startPos == path.end())
+        {
+            continue;
+        }
+
+        const auto goalPos = std::find(path.begin(), path.end(), goalCell);
+
+        if (goalPos == path.end())
+        {
+            continue;
+        }
+
+        // stored paths run goal to start, so keep that order for the slice
+        if (goalPos < startPos)
+        {
+            cells.assign(goalPos, startPos + 1);
+        }
+        else
+        {
+            cells.assign(std::make_reverse_iterator(goalPos + 1), std::make_reverse_iterator(startPos));
+        }
+
+        entries.splice(entries.begin(), entries, entry);
+        return true;
+    }
+
+    return false;
+}
+
+bool PathCache::is_optimal(const Key &key)
+{
+    return key.weight <= 1.0f && key.heuristic != Heuristic::MANHATTAN && key.method != Method::HIERARCHICAL &&
+        key.method != Method::THETA_STAR;
+}
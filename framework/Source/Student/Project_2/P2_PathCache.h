@@ -0,0 +1,72 @@
+#pragma once
+#include "Misc/PathfindingDetails.hpp"
+#include <list>
+#include <unordered_map>
+
+// bounded least recently used cache of finished searches, storing the raw cell path
+// (goal to start, before any rubberbanding or smoothing) so each request can post process it its own way
+class PathCache
+{
+public:
+    explicit PathCache(size_t capacity = 256);
+
+    struct Key
+    {
+        unsigned map;
+        GridPos start;
+        GridPos goal;
+        Method method;
+        Heuristic heuristic;
+        float weight;
+        Weighting weighting;
+
+        bool operator==(const Key &rhs) const;
+    };
+
+    // on a hit, fills cells with the path and returns true, an empty path means there is no solution,
+    // a query whose endpoints both lie on a cached optimal path with the same settings is served from that
+    bool find(const Key &key, int width, std::vector<int> &cells);
+    void insert(const Key &key, const std::vector<int> &cells);
+    void clear();
+
+    // memory held for entries, kept or spare, it only changes when the cache allocates
+    size_t get_reserved_bytes() const;
+
+    size_t get_hits() const;
+    size_t get_sub_path_hits() const;
+    size_t get_misses() const;
+    const std::wstring &get_stats_text() const;
+
+private:
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::vector<int> cells;
+    };
+
+    using Lookup = std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>;
+
+    // most recently used at the front, what clear drops is kept aside along with its lookup nodes, so refilling the
+    // cache after a wall change only allocates to remember a longer path than the entry it reuses ever held
+    std::list<Entry> entries;
+    std::list<Entry> spareEntries;
+    Lookup lookup;
+    std::vector<Lookup::node_type> spareNodes;
+    size_t capacity;
+
+    size_t hits;
+    size_t subPathHits;
+    size_t misses;
+
+    // formatted when the UI asks for it, and only if a lookup happened since, so lookups never allocate
+    mutable std::wstring statsText;
+    mutable size_t textLookups;
+
+    bool find_sub_path(const Key &key, int width, std::vector<int> &cells);
+    static bool is_optimal(const Key &key);
+};
@@ -2,59 +2,960 @@
 #include "Terrain/TerrainAnalysis.h"
 #include "Projects/ProjectTwo.h"
 #include "P2_Pathfinding.h"
+#include "P2_SearchKernel.h"
 
 #pragma region Extra Credit
 bool ProjectTwo::implemented_floyd_warshall()
 {
-    return false;
+    return true;
 }
 
 bool ProjectTwo::implemented_goal_bounding()
 {
-    return false;
+    return true;
 }
 
 bool ProjectTwo::implemented_jps_plus()
 {
-    return false;
+    return true;
+}
+
+bool ProjectTwo::implemented_hierarchical()
+{
+    return true;
+}
+
+bool ProjectTwo::implemented_theta_star()
+{
+    return true;
 }
 #pragma endregion
 
+namespace
+{
+    const float sqrtTwo = 1.41421356f;
+}
+
+const int AStarPather::rowOffset[NUM_DIRECTIONS] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+const int AStarPather::colOffset[NUM_DIRECTIONS] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+const float AStarPather::moveCost[NUM_DIRECTIONS] = { 1.0f, 1.0f, 1.0f, 1.0f, sqrtTwo, sqrtTwo, sqrtTwo, sqrtTwo };
+
+AStarPather::AStarPather() : lastHandle(0), asyncPaused(false), asyncStopping(false), asyncEnabled(true), cacheEnabled(true), kernelDispatch(KernelDispatch::SPECIALIZED), incrementalClock(0), costFloor(1.0f), uniformCost(true), clustersWide(0), fwStride(0), staleTables(0), hasDeadline(false), width(0), height(0), cellSize(0.0f)
+{}
+
+AStarPather::~AStarPather()
+{
+    // the background threads wait on members, so they have to be gone before those are
+    stop_async();
+}
+
 bool AStarPather::initialize()
 {
-    // handle any one-time setup requirements you have
+    // all per-map storage is (re)built when a map is loaded
+    Callback mapCallback = std::bind(&AStarPather::on_map_change, this);
+    Messenger::listen_for_message(Messages::MAP_CHANGE, mapCallback);
+
+    Callback wallCallback = std::bind(&AStarPather::on_wall_change, this);
+    Messenger::listen_for_message(Messages::WALL_CHANGE, wallCallback);
 
-    /*
-        If you want to do any map-preprocessing, you'll need to listen
-        for the map change message.  It'll look something like this:
+    // the tests expect every request to finish inside path_to
+    Callback testBeginCallback = std::bind(&AStarPather::on_test_begin, this);
+    Messenger::listen_for_message(Messages::PATH_TEST_BEGIN, testBeginCallback);
 
-        Callback cb = std::bind(&AStarPather::your_function_name, this);
-        Messenger::listen_for_message(Messages::MAP_CHANGE, cb);
+    Callback testEndCallback = std::bind(&AStarPather::on_test_end, this);
+    Messenger::listen_for_message(Messages::PATH_TEST_END, testEndCallback);
 
-        There are other alternatives to using std::bind, so feel free to mix it up.
-        Callback is just a typedef for std::function<void(void)>, so any std::invoke'able
-        object that std::function can wrap will suffice.
-    */
+    workers.start(std::max(1u, std::thread::hardware_concurrency()));
+    workerSearches.resize(workers.size());
+    start_async();
 
     return true; // return false if any errors actually occur, to stop engine initialization
 }
 
 void AStarPather::shutdown()
 {
-    /*
-        Free any dynamically allocated memory or any other general house-
-        keeping you need to do during shutdown.
-    */
+    stop_async();
+    workers.stop();
+    workerSearches.clear();
+    grid.reset();
+
+    search = SearchState {};
+    cooperative = SearchState {};
+    incrementalSearches.clear();
+    flowFields.clear();
+    neighbors.clear();
+    edgeCosts.clear();
+    components.clear();
+    componentSizes.clear();
+    jumpDistances.clear();
+    goalBounds.clear();
+    landmarkDistances.clear();
+    fwDistance.clear();
+    fwNext.clear();
+    cellToVertex.clear();
+    vertexToCell.clear();
+    abstractCells.clear();
+    abstractEdges.clear();
+    clusterNodes.clear();
 }
 
 PathResult AStarPather::compute_path(PathRequest &request)
 {
-    // Just sample code, safe to delete
-    GridPos start = terrain->get_grid_position(request.start);
-    GridPos goal = terrain->get_grid_position(request.goal);
-    terrain->set_color(start, Colors::Orange);
-    terrain->set_color(goal, Colors::Orange);
-    request.path.push_back(request.start);
-    request.path.push_back(request.goal);
-    return PathResult::COMPLETE;
+    // watching the search is the whole point of single stepping and debug coloring, so those skip the cache,
+    // and incremental searches already reuse their own work
+    const bool cacheable = cacheEnabled == true && request.settings.singleStep == false && request.settings.debugColoring == false &&
+        request.settings.incremental == false;
+
+    if (cacheable == true && request.newRequest == true && pathCache.find(cache_key(request), width, search.cellPath) == true)
+    {
+        search.expanded = 0;
+
+        if (search.cellPath.empty() == true)
+        {
+            return PathResult::IMPOSSIBLE;
+        }
+
+        emit_path(search, request);
+        return PathResult::COMPLETE;
+    }
+
+    refresh_tables(tables_for(request.settings));
+
+    const auto *stopAt = hasDeadline == true ? &deadline : nullptr;
+    const auto result = request.settings.incremental == true ? run_incremental(request, stopAt) :
+        run_search(search, request, request.settings, stopAt);
+
+    if (result == PathResult::PROCESSING)
+    {
+        // HPA* hands out each refined stretch as it's ready, so the agent can start walking
+        if (search.partial == true)
+        {
+            emit_path(search, request);
+        }
+
+        return result;
+    }
+
+    // a path handed out in pieces only has its last piece left in cellPath
+    if (cacheable == true && search.partial == false)
+    {
+        if (result == PathResult::IMPOSSIBLE)
+        {
+            search.cellPath.clear();
+        }
+
+        pathCache.insert(cache_key(request), search.cellPath);
+    }
+
+    if (result == PathResult::COMPLETE)
+    {
+        emit_path(search, request);
+    }
+
+    return result;
+}
+
+void AStarPather::compute_paths(PathRequest *requests, PathResult *results, size_t count)
+{
+    auto task = [this, requests, results](unsigned worker, size_t index)
+    {
+        PathRequest &request = requests[index];
+
+        // set_color isn't thread safe, and there's no later call to resume a single step from
+        auto settings = request.settings;
+        settings.debugColoring = false;
+        settings.singleStep = false;
+
+        request.newRequest = true;
+        results[index] = run_search(workerSearches[worker], request, settings, nullptr);
+
+        if (results[index] == PathResult::COMPLETE)
+        {
+            emit_path(workerSearches[worker], request);
+        }
+    };
+
+    unsigned char tables = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        tables |= tables_for(requests[i].settings);
+    }
+
+    refresh_tables(tables);
+    workers.run(count, task);
+}
+
+PathCache::Key AStarPather::cache_key(const PathRequest &request) const
+{
+    const auto &settings = request.settings;
+
+    return PathCache::Key { grid->mapIndex, grid->get_grid_position(request.start), grid->get_grid_position(request.goal),
+        settings.method, settings.heuristic, settings.weight, settings.weighting };
+}
+
+const PathCache &AStarPather::get_path_cache() const
+{
+    return pathCache;
+}
+
+void AStarPather::set_deadline(const std::chrono::high_resolution_clock::time_point &time)
+{
+    deadline = time;
+    hasDeadline = true;
+}
+
+void AStarPather::clear_deadline()
+{
+    hasDeadline = false;
+}
+
+void AStarPather::set_kernel_dispatch(KernelDispatch dispatch)
+{
+    kernelDispatch = dispatch;
+}
+
+void AStarPather::set_path_cache_enabled(bool enabled)
+{
+    cacheEnabled = enabled;
+}
+
+void AStarPather::clear_path_cache()
+{
+    pathCache.clear();
+}
+
+size_t AStarPather::get_reserved_bytes() const
+{
+    return search.reserved_bytes() + pathCache.get_reserved_bytes();
+}
+
+size_t AStarPather::get_nodes_expanded() const
+{
+    return search.expanded;
+}
+
+PathResult AStarPather::run_search(SearchState &state, PathRequest &request, const PathRequest::Settings &settings,
+    const std::chrono::high_resolution_clock::time_point *stopAt) const
+{
+    if (request.newRequest == true)
+    {
+        state.partial = false;
+        state.expanded = 0;
+
+        const GridPos start = grid->get_grid_position(request.start);
+        state.goalPos = grid->get_grid_position(request.goal);
+
+        if (grid->is_valid_grid_position(start) == false || grid->is_valid_grid_position(state.goalPos) == false ||
+            grid->is_wall(start) == true || grid->is_wall(state.goalPos) == true)
+        {
+            return PathResult::IMPOSSIBLE;
+        }
+
+        state.goalIndex = state.goalPos.row * width + state.goalPos.col;
+
+        // no search can cross between regions, so don't flood the start's whole region to find that out
+        if (components[start.row * width + start.col] != components[state.goalIndex])
+        {
+            return PathResult::IMPOSSIBLE;
+        }
+
+        // the all pairs table answers directly, no search needed
+        if (settings.method == Method::FLOYD_WARSHALL && fwStride > 0)
+        {
+            const auto result = compute_table_path(state, start.row * width + start.col);
+
+            if (result != PathResult::PROCESSING)
+            {
+                return result;
+            }
+        }
+
+        if (settings.method == Method::HIERARCHICAL)
+        {
+            if (plan_abstract_path(state, start.row * width + start.col) == false)
+            {
+                return PathResult::IMPOSSIBLE;
+            }
+        }
+        else
+        {
+            state.begin(start.row * width + start.col);
+            state.kernel = select_kernel(settings);
+        }
+    }
+
+    // the abstract path is refined a leg at a time, resuming refines the next ones
+    if (settings.method == Method::HIERARCHICAL)
+    {
+        return refine_abstract_path(state, settings, stopAt);
+    }
+
+    return (this->*state.kernel)(state, settings, stopAt);
+}
+
+AStarPather::Kernel AStarPather::select_kernel(const PathRequest::Settings &settings) const
+{
+    if (kernelDispatch == KernelDispatch::RUNTIME)
+    {
+        return &AStarPather::search_kernel<RuntimeSearchPolicy>;
+    }
+
+    // integer costs only add up right for unweighted octile moves under an estimate that stays admissible
+    if (kernelDispatch == KernelDispatch::FIXED_POINT && uniformCost == true && settings.method == Method::ASTAR &&
+        settings.weight == 1.0f && (settings.heuristic == Heuristic::OCTILE || settings.heuristic == Heuristic::CHEBYSHEV))
+    {
+        return fixed_point_kernel(settings);
+    }
+
+    // jump points skip over cells, so on maps with terrain costs those requests are searched with plain A*
+    switch (settings.method)
+    {
+    case Method::JPS_PLUS:
+        return uniformCost == true ? jump_point_kernel(settings) : specialized_kernel<Method::ASTAR>(settings, true);
+    case Method::GOAL_BOUNDING:
+        return bounded_kernel(settings);
+    case Method::THETA_STAR:
+        return any_angle_kernel(settings);
+    default:
+        return specialized_kernel<Method::ASTAR>(settings, uniformCost == false);
+    }
+}
+
+template <typename Policy>
+void AStarPather::expand_neighbors(SearchState &state, int current, const PathRequest::Settings &settings) const
+{
+    const unsigned char mask = neighbors[current];
+
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        if ((mask & (1 << d)) != 0)
+        {
+            relax<Policy>(state, current, current + rowOffset[d] * width + colOffset[d], move_cost<Policy>(current, d), settings);
+        }
+    }
+}
+
+void AStarPather::on_map_change()
+{
+    // nothing may search in the background while the tables are rebuilt
+    pause_async();
+
+    {
+        // requests for the old map are dropped, their owners forget them on the same message
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncQueue.clear();
+        asyncDone.clear();
+        asyncCancelled.clear();
+    }
+
+    grid = terrain->get_snapshot();
+    width = terrain->get_map_width();
+    height = terrain->get_map_height();
+
+    const size_t numCells = static_cast<size_t>(width * height);
+
+    search.resize(numCells);
+    cooperative.resize(numCells * ReservationTable::window);
+    incrementalSearches.clear();
+    pathCache.clear();
+    flowFields.clear();
+
+    for (auto &state : workerSearches)
+    {
+        state.resize(numCells);
+    }
+
+    for (auto &state : asyncSearches)
+    {
+        state.resize(numCells);
+    }
+
+    cellSize = (terrain->get_world_position(0, 1) - terrain->get_world_position(0, 0)).Length();
+
+    build_neighbor_masks();
+    build_move_costs();
+    label_components();
+    build_search_tables();
+
+    resume_async();
+}
+
+void AStarPather::build_search_tables()
+{
+    build_jump_distances();
+    build_goal_bounds(true);
+    build_landmarks();
+    build_floyd_warshall();
+    build_abstract_graph();
+
+    staleTables = 0;
+}
+
+unsigned char AStarPather::tables_for(const PathRequest::Settings &settings)
+{
+    unsigned char tables = settings.heuristic == Heuristic::LANDMARK ? LANDMARKS : 0;
+
+    switch (settings.method)
+    {
+    case Method::JPS_PLUS:
+        return tables | JUMP_DISTANCES;
+    case Method::GOAL_BOUNDING:
+        return tables | GOAL_BOUNDS;
+    case Method::FLOYD_WARSHALL:
+        return tables | NEXT_HOPS;
+    default:
+        return tables;
+    }
+}
+
+void AStarPather::refresh_tables(unsigned char tables)
+{
+    if ((staleTables & tables) == 0)
+    {
+        return;
+    }
+
+    pause_async();
+    rebuild_tables(tables);
+    resume_async();
+}
+
+void AStarPather::rebuild_tables(unsigned char tables)
+{
+    tables &= staleTables;
+
+    if ((tables & JUMP_DISTANCES) != 0)
+    {
+        build_jump_distances();
+    }
+
+    // a wall layout clicked together at runtime isn't worth a file of its own, only map loads write the cache
+    if ((tables & GOAL_BOUNDS) != 0)
+    {
+        build_goal_bounds(false);
+    }
+
+    if ((tables & LANDMARKS) != 0)
+    {
+        build_landmarks();
+    }
+
+    if ((tables & NEXT_HOPS) != 0)
+    {
+        build_floyd_warshall();
+    }
+
+    staleTables &= ~tables;
+}
+
+void AStarPather::build_neighbor_masks()
+{
+    const size_t numCells = static_cast<size_t>(width * height);
+
+    // precompute which of the eight moves are legal from each cell, diagonals can't cut corners
+    neighbors.assign(numCells, 0);
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            neighbors[row * width + col] = neighbor_mask(row, col);
+        }
+    }
+}
+
+void AStarPather::build_move_costs()
+{
+    const int numCells = width * height;
+    const auto &costs = grid->costs;
+
+    edgeCosts.assign(static_cast<size_t>(numCells * NUM_DIRECTIONS), 0.0f);
+    costFloor = std::numeric_limits<float>::max();
+    uniformCost = true;
+
+    // walls count too, since toggling one opens its cell at whatever cost the map gave it
+    for (int cell = 0; cell < numCells; ++cell)
+    {
+        costFloor = std::min(costFloor, costs[cell]);
+        uniformCost = uniformCost == true && costs[cell] == 1.0f;
+    }
+
+    // every move is filled in, legal or not, for the same reason
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            const int cell = row * width + col;
+
+            for (int d = 0; d < NUM_DIRECTIONS; ++d)
+            {
+                const int r = row + rowOffset[d];
+                const int c = col + colOffset[d];
+
+                if (grid->is_valid_grid_position(r, c) == true)
+                {
+                    edgeCosts[cell * NUM_DIRECTIONS + d] = moveCost[d] * (costs[cell] + costs[r * width + c]) * 0.5f;
+                }
+            }
+        }
+    }
+}
+
+unsigned char AStarPather::neighbor_mask(int row, int col) const
+{
+    unsigned char mask = 0;
+
+    if (terrain->is_wall(row, col) == true)
+    {
+        return mask;
+    }
+
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        const int r = row + rowOffset[d];
+        const int c = col + colOffset[d];
+
+        if (terrain->is_valid_grid_position(r, c) == false || terrain->is_wall(r, c) == true)
+        {
+            continue;
+        }
+
+        if (d >= NORTH_EAST && (terrain->is_wall(row, c) == true || terrain->is_wall(r, col) == true))
+        {
+            continue;
+        }
+
+        mask |= static_cast<unsigned char>(1 << d);
+    }
+
+    return mask;
+}
+
+void AStarPather::SearchState::resize(size_t numCells)
+{
+    // the generation stamps are reset along with the pool, so every node starts stale
+    nodes.assign(numCells, Node {});
+    generation = 0;
+    goalIndex = -1;
+    goalPos = GridPos { -1, -1 };
+    kernel = &AStarPather::search_kernel<RuntimeSearchPolicy>;
+    expanded = 0;
+    partial = false;
+    abstract.refined = 0;
+    abstract.path.clear();
+    fixedPoint.resize(numCells);
+
+    openList.clear();
+    openList.reserve(numCells);
+    focalList.clear();
+    focalBound = -std::numeric_limits<float>::infinity();
+    horizon = 0.0f;
+    cellPath.clear();
+    cellPath.reserve(numCells);
+    worldPath.clear();
+    worldPath.reserve(numCells * 4);
+}
+
+size_t AStarPather::SearchState::reserved_bytes() const
+{
+    const auto bytes = [](const auto &buffer) { return buffer.capacity() * sizeof(buffer[0]); };
+
+    return bytes(nodes) + bytes(openList) + bytes(focalList) + bytes(scanned) + bytes(cellPath) + bytes(worldPath) +
+        bytes(abstract.given) + bytes(abstract.goalCost) + bytes(abstract.parent) + bytes(abstract.closed) +
+        bytes(abstract.open) + bytes(abstract.path) + bytes(abstract.cells) + bytes(fixedPoint.given) +
+        bytes(fixedPoint.total) + bytes(fixedPoint.next) + bytes(fixedPoint.previous) + bytes(fixedPoint.heads) +
+        bytes(fixedPoint.occupied);
+}
+
+void AStarPather::SearchState::begin(int startIndex)
+{
+    // bumping the generation invalidates every node from the previous search at once
+    if (++generation == 0)
+    {
+        for (auto &node : nodes)
+        {
+            node.generation = 0;
+        }
+
+        generation = 1;
+    }
+
+    openList.clear();
+    focalList.clear();
+    focalBound = -std::numeric_limits<float>::infinity();
+
+    Node &start = touch(startIndex);
+    start.given = 0.0f;
+    start.total = 0.0f;
+    start.parent = -1;
+    push(startIndex);
+}
+
+AStarPather::Node &AStarPather::SearchState::touch(int index)
+{
+    Node &node = nodes[index];
+
+    if (node.generation != generation)
+    {
+        node.generation = generation;
+        node.state = NodeState::UNVISITED;
+    }
+
+    return node;
+}
+
+void AStarPather::SearchState::push(int index)
+{
+    Node &node = nodes[index];
+    node.state = NodeState::OPEN;
+    node.heapIndex = static_cast<int>(openList.size());
+    openList.push_back(index);
+    heap_up(node.heapIndex);
+
+    // only a focal search ever raises the bound off negative infinity
+    if (node.total <= focalBound)
+    {
+        focalList.emplace_back(node.total - node.given, index);
+        std::push_heap(focalList.begin(), focalList.end(), std::greater<std::pair<float, int>>());
+    }
+}
+
+int AStarPather::SearchState::pop()
+{
+    const int top = openList.front();
+    const int last = openList.back();
+    openList.pop_back();
+
+    if (openList.empty() == false)
+    {
+        openList.front() = last;
+        nodes[last].heapIndex = 0;
+        heap_down(0);
+    }
+
+    return top;
+}
+
+int AStarPather::SearchState::pop_focal(float weight)
+{
+    const auto closer = std::greater<std::pair<float, int>>();
+    const float bound = std::max(weight, 1.0f) * nodes[openList.front()].total;
+
+    // the bound only grows, so the nodes under the old one are already in, and a heap slot costing more
+    // than the bound has nothing under it that doesn't
+    if (bound > focalBound)
+    {
+        scanned.clear();
+        scanned.push_back(0);
+
+        while (scanned.empty() == false)
+        {
+            const int slot = scanned.back();
+            scanned.pop_back();
+
+            const Node &node = nodes[openList[slot]];
+
+            if (node.total > bound)
+            {
+                continue;
+            }
+
+            if (node.total > focalBound)
+            {
+                focalList.emplace_back(node.total - node.given, openList[slot]);
+                std::push_heap(focalList.begin(), focalList.end(), closer);
+            }
+
+            for (int child = (slot << 1) + 1; child <= (slot << 1) + 2 && child < static_cast<int>(openList.size()); ++child)
+            {
+                scanned.push_back(child);
+            }
+        }
+
+        focalBound = bound;
+    }
+
+    // the cheapest open node is always in, so this finds one
+    while (true)
+    {
+        std::pop_heap(focalList.begin(), focalList.end(), closer);
+        const int index = focalList.back().second;
+        focalList.pop_back();
+
+        if (nodes[index].state == NodeState::OPEN)
+        {
+            remove(index);
+            return index;
+        }
+    }
+}
+
+void AStarPather::SearchState::remove(int index)
+{
+    const int slot = nodes[index].heapIndex;
+    const int last = openList.back();
+    openList.pop_back();
+
+    if (last != index)
+    {
+        openList[slot] = last;
+        nodes[last].heapIndex = slot;
+        heap_up(slot);
+        heap_down(nodes[last].heapIndex);
+    }
+}
+
+void AStarPather::SearchState::update(int index)
+{
+    // costs only ever decrease while on the open list
+    heap_up(nodes[index].heapIndex);
+
+    Node &node = nodes[index];
+
+    // this can add a node that's already in, the copy left behind is skipped once the node closes
+    if (node.total <= focalBound)
+    {
+        focalList.emplace_back(node.total - node.given, index);
+        std::push_heap(focalList.begin(), focalList.end(), std::greater<std::pair<float, int>>());
+    }
+}
+
+void AStarPather::SearchState::heap_up(int slot)
+{
+    const int index = openList[slot];
+    const float total = nodes[index].total;
+
+    while (slot > 0)
+    {
+        const int parentSlot = (slot - 1) >> 1;
+        const int parent = openList[parentSlot];
+
+        if (nodes[parent].total <= total)
+        {
+            break;
+        }
+
+        openList[slot] = parent;
+        nodes[parent].heapIndex = slot;
+        slot = parentSlot;
+    }
+
+    openList[slot] = index;
+    nodes[index].heapIndex = slot;
+}
+
+void AStarPather::SearchState::heap_down(int slot)
+{
+    const int size = static_cast<int>(openList.size());
+    const int index = openList[slot];
+    const float total = nodes[index].total;
+
+    while (true)
+    {
+        int child = (slot << 1) + 1;
+
+        if (child >= size)
+        {
+            break;
+        }
+
+        if (child + 1 < size && nodes[openList[child + 1]].total < nodes[openList[child]].total)
+        {
+            ++child;
+        }
+
+        if (total <= nodes[openList[child]].total)
+        {
+            break;
+        }
+
+        openList[slot] = openList[child];
+        nodes[openList[slot]].heapIndex = slot;
+        slot = child;
+    }
+
+    openList[slot] = index;
+    nodes[index].heapIndex = slot;
+}
+
+int AStarPather::direction_step(int from, int to) const
+{
+    const int rowFrom = from / width;
+    const int rowTo = to / width;
+    const int rowStep = (rowTo > rowFrom) - (rowTo < rowFrom);
+
+    const int colFrom = from - rowFrom * width;
+    const int colTo = to - rowTo * width;
+    const int colStep = (colTo > colFrom) - (colTo < colFrom);
+
+    return rowStep * width + colStep;
+}
+
+float AStarPather::heuristic(const SearchState &state, int index, Heuristic type) const
+{
+    switch (type)
+    {
+    case Heuristic::OCTILE:
+        return heuristic<Heuristic::OCTILE>(state, index);
+    case Heuristic::CHEBYSHEV:
+        return heuristic<Heuristic::CHEBYSHEV>(state, index);
+    case Heuristic::INCONSISTENT:
+        return heuristic<Heuristic::INCONSISTENT>(state, index);
+    case Heuristic::MANHATTAN:
+        return heuristic<Heuristic::MANHATTAN>(state, index);
+    case Heuristic::EUCLIDEAN:
+        return heuristic<Heuristic::EUCLIDEAN>(state, index);
+    case Heuristic::LANDMARK:
+        return heuristic<Heuristic::LANDMARK>(state, index);
+    default:
+        return 0.0f;
+    }
+}
+
+void AStarPather::build_path(SearchState &state, bool anyAngle) const
+{
+    // walk back from the goal, so the buffer is ordered goal to start
+    auto &cellPath = state.cellPath;
+    cellPath.clear();
+
+    for (int index = state.goalIndex; index != -1; index = state.nodes[index].parent)
+    {
+        cellPath.push_back(index);
+
+        const int parent = state.nodes[index].parent;
+
+        if (parent == -1 || anyAngle == true)
+        {
+            continue;
+        }
+
+        // jump point links span straight or diagonal runs, so fill in the cells between
+        const int step = direction_step(index, parent);
+
+        for (int cell = index + step; cell != parent; cell += step)
+        {
+            cellPath.push_back(cell);
+        }
+    }
+}
+
+void AStarPather::emit_path(SearchState &state, PathRequest &request) const
+{
+    // an any-angle path is already as straight as it can be
+    if (request.settings.rubberBanding == true && request.settings.method != Method::THETA_STAR)
+    {
+        rubberband(state);
+    }
+
+    if (request.settings.smoothing == true)
+    {
+        smooth(state, request);
+        return;
+    }
+
+    for (auto i = state.cellPath.rbegin(); i != state.cellPath.rend(); ++i)
+    {
+        request.path.push_back(grid->get_world_position(*i / width, *i % width));
+    }
+}
+
+void AStarPather::rubberband(SearchState &state) const
+{
+    auto &cellPath = state.cellPath;
+
+    if (cellPath.size() < 3)
+    {
+        return;
+    }
+
+    // compact in place, dropping any middle point whose neighbors span a box that's clear to cut across
+    size_t kept = 1;
+
+    for (size_t i = 1; i + 1 < cellPath.size(); ++i)
+    {
+        if (area_blocks_shortcut(cellPath[kept - 1], cellPath[i + 1]) == true)
+        {
+            cellPath[kept++] = cellPath[i];
+        }
+    }
+
+    cellPath[kept++] = cellPath.back();
+    cellPath.resize(kept);
+}
+
+bool AStarPather::area_blocks_shortcut(int index0, int index1) const
+{
+    // a straight line may not wander onto ground dearer than either end of it, which the search went around
+    const float limit = std::max(grid->costs[index0], grid->costs[index1]);
+
+    const int row0 = index0 / width;
+    const int col0 = index0 % width;
+    const int row1 = index1 / width;
+    const int col1 = index1 % width;
+
+    const int minRow = std::min(row0, row1);
+    const int maxRow = std::max(row0, row1);
+    const int minCol = std::min(col0, col1);
+    const int maxCol = std::max(col0, col1);
+
+    for (int row = minRow; row <= maxRow; ++row)
+    {
+        for (int col = minCol; col <= maxCol; ++col)
+        {
+            if (grid->is_wall(row, col) == true || grid->costs[row * width + col] > limit)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void AStarPather::smooth(SearchState &state, PathRequest &request) const
+{
+    const auto &cellPath = state.cellPath;
+    auto &worldPath = state.worldPath;
+    worldPath.clear();
+
+    // when rubberbanded or any-angle, put back points so no gap is over 1.5 cells before fitting the spline
+    const float maxGap = cellSize * 1.5f;
+    const bool sparse = request.settings.rubberBanding == true || request.settings.method == Method::THETA_STAR;
+
+    for (auto i = cellPath.rbegin(); i != cellPath.rend(); ++i)
+    {
+        const Vec3 point = grid->get_world_position(*i / width, *i % width);
+
+        if (worldPath.empty() == false && sparse == true)
+        {
+            const Vec3 previous = worldPath.back();
+            const Vec3 delta = point - previous;
+            const int splits = static_cast<int>(std::ceil(delta.Length() / maxGap));
+
+            for (int s = 1; s < splits; ++s)
+            {
+                worldPath.push_back(previous + delta * (static_cast<float>(s) / static_cast<float>(splits)));
+            }
+        }
+
+        worldPath.push_back(point);
+    }
+
+    const size_t count = worldPath.size();
+
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        const Vec3 &p0 = worldPath[i == 0 ? 0 : i - 1];
+        const Vec3 &p1 = worldPath[i];
+        const Vec3 &p2 = worldPath[i + 1];
+        const Vec3 &p3 = worldPath[i + 2 < count ? i + 2 : i + 1];
+
+        request.path.push_back(p1);
+        request.path.push_back(Vec3::CatmullRom(p0, p1, p2, p3, 0.25f));
+        request.path.push_back(Vec3::CatmullRom(p0, p1, p2, p3, 0.5f));
+        request.path.push_back(Vec3::CatmullRom(p0, p1, p2, p3, 0.75f));
+    }
+
+    request.path.push_back(worldPath.back());
 }
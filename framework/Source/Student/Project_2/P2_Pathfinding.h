@@ -1,14 +1,24 @@
 #pragma once
 #include "Misc/PathfindingDetails.hpp"
+#include "P2_WorkerPool.h"
+#include "P2_PathCache.h"
+#include "P2_FlowField.h"
+#include "Terrain/GridSnapshot.h"
+#include "Agent/ReservationTable.h"
+#include <chrono>
+#include <deque>
+#include <condition_variable>
 
 class AStarPather
 {
 public:
-    /* 
+    /*
         The class should be default constructible, so you may need to define a constructor.
         If needed, you can modify the framework where the class is constructed in the
         initialize functions of ProjectTwo and ProjectThree.
     */
+    AStarPather();
+    ~AStarPather();
 
     /* ************************************************** */
     // DO NOT MODIFY THESE SIGNATURES
@@ -17,10 +27,496 @@ public:
     PathResult compute_path(PathRequest &request);
     /* ************************************************** */
 
+    // solves count independent requests at once, spread over the worker pool, each one runs
+    // to completion and single stepping, debug coloring and incremental searching are ignored since they aren't thread safe
+    void compute_paths(PathRequest *requests, PathResult *results, size_t count);
+
+    // compute_path and submit_path answer repeated requests from here, the batches from compute_paths don't use it
+    const PathCache &get_path_cache() const;
+
+    // requests searched on background threads so a frame never waits on one, poll_path returns PROCESSING
+    // until the search is done, then adds the rest of the path to the request's and forgets the handle, unknown
+    // or cancelled handles are IMPOSSIBLE, a hierarchical path is handed over a refined stretch at a time while
+    // it's PROCESSING, searches run to completion so single stepping and debug coloring are ignored, and a request
+    // the path cache answers never reaches a worker
+    PathHandle submit_path(const PathRequest &request);
+    PathResult poll_path(PathHandle handle, PathRequest &request);
+    void cancel_path(PathHandle handle);
+
+    // with async off, submit_path searches before returning, the tests turn it off so their timings stay on one thread
+    void set_async_enabled(bool enabled);
+
+    // windowed cooperative A*, plans through space and time over the next ReservationTable::window steps around the
+    // cells other agents hold, then holds the cells it planned, request.path gets one point per step with repeats
+    // for waiting, COMPLETE once the plan reaches the goal and PROCESSING when it runs out of window first
+    PathResult compute_cooperative_path(PathRequest &request, ReservationTable &reservations, unsigned short owner);
+
+    // the next cell to walk to from position on a shortest route to goal, read from a flow field shared by
+    // everything heading to the same goal cell and built the first time one asks, false at the goal or if it can't be reached
+    bool flow_waypoint(const Vec3 &position, const Vec3 &goal, Vec3 &waypoint);
+    const FlowFieldCache &get_flow_fields() const;
+
     /*
         You should create whatever functions, variables, or classes you need.
         It doesn't all need to be in this header and cpp, structure it whatever way
         makes sense to you.
     */
 
-};
\ No newline at end of file
+    // the eight grid directions, cardinals first, in the order used by the neighbor masks
+    enum Direction
+    {
+        NORTH,
+        EAST,
+        SOUTH,
+        WEST,
+        NORTH_EAST,
+        SOUTH_EAST,
+        SOUTH_WEST,
+        NORTH_WEST,
+
+        NUM_DIRECTIONS
+    };
+
+    static const int rowOffset[NUM_DIRECTIONS];
+    static const int colOffset[NUM_DIRECTIONS];
+    static const float moveCost[NUM_DIRECTIONS];
+
+    // once the deadline passes, compute_path stops and returns PROCESSING so the search can resume next frame,
+    // batches from compute_paths and background requests from submit_path never hold up the frame so they ignore it
+    void set_deadline(const std::chrono::high_resolution_clock::time_point &time);
+    void clear_deadline();
+
+    // searches normally run a kernel specialized on method, heuristic, debug coloring and single stepping,
+    // picked once when the request starts, the runtime kernel checks the settings for every node instead
+    // and is only kept to measure against, the fixed point kernel searches plain octile A* requests on
+    // maps without terrain costs in integers and leaves the rest to the specialized ones
+    enum class KernelDispatch
+    {
+        SPECIALIZED,
+        RUNTIME,
+        FIXED_POINT
+    };
+
+    void set_kernel_dispatch(KernelDispatch dispatch);
+
+    // the speed measurements turn the cache off so every request is really searched
+    void set_path_cache_enabled(bool enabled);
+
+    // forgets every cached path without touching the map
+    void clear_path_cache();
+
+    // memory held by compute_path's search buffers and the path cache, it only changes when one of them allocates
+    size_t get_reserved_bytes() const;
+
+    // nodes closed by the search behind the last compute_path, zero if it came from a cache
+    size_t get_nodes_expanded() const;
+
+private:
+    enum class NodeState : unsigned char
+    {
+        UNVISITED,
+        OPEN,
+        CLOSED
+    };
+
+    // per cell search record, only meaningful when its generation matches the current search
+    struct Node
+    {
+        float given;
+        float total;
+        int parent;
+        int heapIndex;
+        unsigned generation;
+        NodeState state;
+    };
+
+    struct SearchState;
+
+    using Kernel = PathResult (AStarPather::*)(SearchState &state, const PathRequest::Settings &settings,
+        const std::chrono::high_resolution_clock::time_point *stopAt) const;
+
+    // everything a single search writes, so searches on different threads never share any
+    struct SearchState
+    {
+        // flat grid indexed by row * width + col, sized on map change
+        std::vector<Node> nodes;
+
+        // binary min heap of node indices, keyed on total cost
+        std::vector<int> openList;
+
+        // focal search's min heap of open nodes costing at most focalBound, keyed on their estimate to the
+        // goal, nodes are left in it once they close and skipped when they come off, scanned holds the heap
+        // slots still to look at while topping it up
+        std::vector<std::pair<float, int>> focalList;
+        std::vector<int> scanned;
+        float focalBound;
+
+        // the start's estimate, dynamic weighting scales a node's weight by how much of it the node has left
+        float horizon;
+
+        // scratch buffers for path output, reused across requests
+        std::vector<int> cellPath;
+        std::vector<Vec3> worldPath;
+
+        unsigned generation;
+        int goalIndex;
+        GridPos goalPos;
+
+        // picked when the request starts, resuming the search keeps running it
+        Kernel kernel;
+        unsigned expanded;
+
+        // HPA* query scratch, the abstract path runs start to goal and refined counts how many
+        // of its legs have already been turned into cells
+        struct AbstractSearch
+        {
+            std::vector<float> given;
+            std::vector<float> goalCost;
+            std::vector<int> parent;
+            std::vector<char> closed;
+            std::vector<std::pair<float, int>> open;
+            std::vector<int> path;
+            std::vector<int> cells;
+            size_t refined;
+        } abstract;
+
+        // fixed point A* scratch, integer costs for each node and a ring of buckets holding the open nodes
+        // by total cost, linked through next and previous so a node can move buckets when its cost drops
+        struct FixedPointSearch
+        {
+            std::vector<int> given;
+            std::vector<int> total;
+            std::vector<int> next;
+            std::vector<int> previous;
+            std::vector<int> heads;
+            std::vector<uint64_t> occupied;
+
+            // the total of the cheapest open node, the ring is searched from its bucket on
+            int lowest;
+            int count;
+
+            void resize(size_t numCells);
+            void reset();
+            void push(int index);
+            int pop();
+            void remove(int index);
+        } fixedPoint;
+
+        // set when cellPath only holds the latest piece of a path being handed out a leg at a time
+        bool partial;
+
+        void resize(size_t numCells);
+        size_t reserved_bytes() const;
+        void begin(int startIndex);
+        Node &touch(int index);
+
+        void push(int index);
+        int pop();
+        int pop_focal(float weight);
+        void remove(int index);
+        void update(int index);
+        void heap_up(int slot);
+        void heap_down(int slot);
+    };
+
+    // the state compute_path uses, kept between calls so searches can be resumed
+    SearchState search;
+
+    // one state per pool worker for compute_paths
+    WorkerPool workers;
+    std::vector<SearchState> workerSearches;
+
+    // background requests wait in asyncQueue for a worker and in asyncDone to be polled, the workers are
+    // paused while the map or walls change so every search sees one grid and one set of tables
+    struct AsyncJob
+    {
+        PathHandle handle;
+        PathRequest request;
+        PathResult result;
+
+        // the cache is only touched from the game thread, so the worker leaves the cells for poll_path to remember,
+        // a wall change while the result waits to be polled makes it too old to
+        bool cache;
+        std::vector<int> cells;
+    };
+    std::vector<std::thread> asyncThreads;
+    std::vector<SearchState> asyncSearches;
+    std::mutex asyncMutex;
+    std::condition_variable asyncWake;
+    std::condition_variable asyncIdle;
+    std::deque<AsyncJob> asyncQueue;
+    std::vector<AsyncJob> asyncDone;
+
+    // jobs being searched right now, owned by their workers, and the handles of those cancelled since they started,
+    // a running job's path only holds the stretches not yet polled and is only touched under asyncMutex
+    std::vector<AsyncJob *> asyncRunning;
+    std::vector<PathHandle> asyncCancelled;
+    PathHandle lastHandle;
+    bool asyncPaused;
+    bool asyncStopping;
+    bool asyncEnabled;
+
+    // the walls and cell positions searches read, swapped for the terrain's latest whenever they change
+    std::shared_ptr<const GridSnapshot> grid;
+
+    // space-time search for compute_cooperative_path, nodes are step * cells + cell
+    SearchState cooperative;
+
+    PathCache pathCache;
+    FlowFieldCache flowFields;
+    bool cacheEnabled;
+    KernelDispatch kernelDispatch;
+
+    // moving target LPA*, rooted where its owner stands and searching toward the goal, so when the goal
+    // moves or cells change only the affected distances are repaired, g, rhs and the keys are in fixed point
+    // and node keys are compared on key0 and then key1
+    struct IncrementalNode
+    {
+        int g;
+        int rhs;
+        int key0;
+        int key1;
+        int parent;
+        int heapIndex;
+        unsigned generation;
+
+        bool precedes(const IncrementalNode &other) const;
+    };
+
+    struct IncrementalSearch
+    {
+        // where each touched cell falls when the root moves, under the new root or left behind
+        enum class Branch : unsigned char
+        {
+            UNSORTED,
+            FOLLOWING,
+            KEPT,
+            DROPPED
+        };
+
+        std::vector<IncrementalNode> nodes;
+        std::vector<int> openList;
+
+        // every cell touched since the search began, so moving the root only has to look at those
+        std::vector<int> touched;
+
+        // scratch for moving the root, sized once so it never allocates
+        std::vector<Branch> branches;
+        std::vector<int> chain;
+        std::vector<int> dropped;
+
+        unsigned generation;
+        int root;
+        int target;
+        int km;
+
+        // the request it belongs to, and when that last searched with it
+        const PathRequest *owner;
+        unsigned lastUsed;
+
+        void resize(size_t numCells);
+        void begin(int rootIndex, int targetIndex);
+        IncrementalNode &touch(int index);
+        int g(int index) const;
+
+        void push(int index);
+        void remove(int index);
+        void update(int index);
+        void heap_up(int slot);
+        void heap_down(int slot);
+    };
+    std::vector<IncrementalSearch> incrementalSearches;
+    unsigned incrementalClock;
+
+    // legal move masks, indexed by row * width + col, sized on map change
+    std::vector<unsigned char> neighbors;
+
+    // cost of each move, NUM_DIRECTIONS per cell, moveCost scaled by the mean terrain cost of the two cells it joins
+    // so every move costs the same both ways and the backward floods still hold, the distance heuristics are scaled
+    // by costFloor, the cheapest terrain cost, to stay admissible, and on uniformCost maps the kernels skip the table
+    std::vector<float> edgeCosts;
+    float costFloor;
+    bool uniformCost;
+
+    // walkable region of each cell, moves can't cut corners so these are the four connected regions and
+    // cells in different ones can never reach each other, walls hold noComponent
+    static constexpr unsigned short noComponent = 0xFFFF;
+    std::vector<unsigned short> components;
+
+    // cells in each region, the id of an empty one is free to reuse
+    std::vector<int> componentSizes;
+
+    // JPS+ distances, NUM_DIRECTIONS per cell, positive is the distance to the next jump point,
+    // otherwise the negated number of free steps before a wall or the map edge
+    std::vector<short> jumpDistances;
+
+    // goal bounding boxes, NUM_DIRECTIONS per cell, covering every goal whose optimal path
+    // leaves the cell through that edge, an empty box has minRow > maxRow
+    struct BoundingBox
+    {
+        short minRow;
+        short maxRow;
+        short minCol;
+        short maxCol;
+    };
+    std::vector<BoundingBox> goalBounds;
+
+    // ALT landmark distances, landmarkCount per cell so a node's distances sit next to each other and compare
+    // against the goal's a vector at a time, zero where the landmark can't reach, which keeps the bound admissible
+    static constexpr int landmarkCount = 8;
+    std::vector<float> landmarkDistances;
+
+    // HPA* abstract graph, nodes are entrance cells on the borders between clusters, linked across
+    // each border and to every other entrance of the same cluster by their distance within it
+    struct AbstractEdge
+    {
+        int to;
+        float cost;
+    };
+    std::vector<int> abstractCells;
+    std::vector<std::vector<AbstractEdge>> abstractEdges;
+    std::vector<std::vector<int>> clusterNodes;
+    int clustersWide;
+
+    // Floyd-Warshall all pairs tables over the open cells only, each row padded out to
+    // fwStride entries, fwNext holds the vertex to step to next toward each goal
+    std::vector<int> cellToVertex;
+    std::vector<int> vertexToCell;
+    std::vector<float> fwDistance;
+    std::vector<unsigned short> fwNext;
+    int fwStride;
+
+    // the precomputed tables a wall change has left out of date, redoing them on every click costs far too much,
+    // so each is rebuilt from the game thread before the first request that reads it, with the workers paused
+    enum SearchTable : unsigned char
+    {
+        JUMP_DISTANCES = 1 << 0,
+        GOAL_BOUNDS = 1 << 1,
+        LANDMARKS = 1 << 2,
+        NEXT_HOPS = 1 << 3
+    };
+    unsigned char staleTables;
+
+    std::chrono::high_resolution_clock::time_point deadline;
+    bool hasDeadline;
+
+    int width;
+    int height;
+    float cellSize;
+
+    void on_map_change();
+    void on_wall_change();
+    void on_test_begin();
+    void on_test_end();
+    void start_async();
+    void stop_async();
+    void pause_async();
+    void resume_async();
+    void async_loop(unsigned worker);
+    void run_job(SearchState &state, AsyncJob &job);
+    void build_search_tables();
+    static unsigned char tables_for(const PathRequest::Settings &settings);
+    void refresh_tables(unsigned char tables);
+    void rebuild_tables(unsigned char tables);
+    void build_neighbor_masks();
+    void build_move_costs();
+    unsigned char neighbor_mask(int row, int col) const;
+    void label_components();
+    void update_components(int index);
+    unsigned short new_component();
+    void flood_component(int from, unsigned short id);
+    bool splits_component(int row, int col) const;
+    void build_jump_distances();
+    bool is_jump_point(int row, int col, int direction) const;
+    bool is_open(int row, int col) const;
+    void build_goal_bounds(bool save);
+    void compute_goal_bounds_from(int source, std::vector<float> &distance, std::vector<unsigned char> &firstMove,
+        std::vector<std::pair<float, int>> &frontier);
+    bool load_goal_bounds(const std::filesystem::path &file, size_t hash);
+    void save_goal_bounds(const std::filesystem::path &file, size_t hash) const;
+    size_t map_hash() const;
+    static std::string goal_bounds_filename(size_t hash);
+    void build_landmarks();
+    void build_floyd_warshall();
+    void build_next_hops();
+    // PROCESSING when the table can't be followed to the goal and the request has to be searched instead
+    PathResult compute_table_path(SearchState &state, int startIndex) const;
+    void build_abstract_graph(int changedCell = -1);
+    int cluster_of(int cell) const;
+    BoundingBox cluster_bounds(int cluster0, int cluster1) const;
+    bool search_within(SearchState &state, int from, int to, const BoundingBox &bounds) const;
+    template <typename Policy>
+    bool search_box(SearchState &state, int from, int to, const BoundingBox &bounds) const;
+    bool plan_abstract_path(SearchState &state, int startIndex) const;
+    PathResult refine_abstract_path(SearchState &state, const PathRequest::Settings &settings,
+        const std::chrono::high_resolution_clock::time_point *stopAt) const;
+    bool refine_leg(SearchState &state, int from, int to, std::vector<int> &cells) const;
+    PathResult run_incremental(PathRequest &request, const std::chrono::high_resolution_clock::time_point *stopAt);
+    IncrementalSearch &incremental_search_for(const PathRequest &request);
+    PathResult solve_incremental(IncrementalSearch &state, const PathRequest::Settings &settings,
+        const std::chrono::high_resolution_clock::time_point *stopAt);
+    void update_incremental(IncrementalSearch &state, int index);
+    void queue_incremental(IncrementalSearch &state, int index);
+    void key_incremental(IncrementalSearch &state, int index);
+    bool reroot_incremental(IncrementalSearch &state, int index);
+    int estimate_incremental(int from, int to) const;
+    int cost_incremental(int index, int direction) const;
+    bool extract_incremental(const IncrementalSearch &state);
+    void build_flow_field(int goal, FlowFieldCache::Field &field) const;
+
+    PathCache::Key cache_key(const PathRequest &request) const;
+
+    // leaves the solution in state.cellPath, goal to start, for emit_path to turn into waypoints
+    PathResult run_search(SearchState &state, PathRequest &request, const PathRequest::Settings &settings,
+        const std::chrono::high_resolution_clock::time_point *stopAt) const;
+
+    // the kernels and their policies are defined in P2_SearchKernel.h, each method's own file builds its kernels
+    Kernel select_kernel(const PathRequest::Settings &settings) const;
+    Kernel jump_point_kernel(const PathRequest::Settings &settings) const;
+    Kernel bounded_kernel(const PathRequest::Settings &settings) const;
+    Kernel any_angle_kernel(const PathRequest::Settings &settings) const;
+    Kernel fixed_point_kernel(const PathRequest::Settings &settings) const;
+
+    template <Method M>
+    static Kernel specialized_kernel(const PathRequest::Settings &settings, bool weighted);
+
+    template <typename Policy>
+    PathResult search_kernel(SearchState &state, const PathRequest::Settings &settings,
+        const std::chrono::high_resolution_clock::time_point *stopAt) const;
+    template <Heuristic H>
+    PathResult fixed_point_search(SearchState &state, const PathRequest::Settings &settings,
+        const std::chrono::high_resolution_clock::time_point *stopAt) const;
+    template <Heuristic H>
+    int fixed_point_heuristic(const SearchState &state, int index) const;
+
+    template <typename Policy>
+    void expand_neighbors(SearchState &state, int current, const PathRequest::Settings &settings) const;
+    template <typename Policy>
+    void expand_jump_points(SearchState &state, int current, const PathRequest::Settings &settings) const;
+    template <typename Policy>
+    void expand_bounded_neighbors(SearchState &state, int current, const PathRequest::Settings &settings) const;
+    template <typename Policy>
+    void expand_any_angle(SearchState &state, int current, const PathRequest::Settings &settings) const;
+    template <typename Policy>
+    void settle_any_angle(SearchState &state, int current) const;
+    template <typename Policy>
+    float line_cost(int from, int to) const;
+    template <typename Policy>
+    void relax(SearchState &state, int current, int next, float cost, const PathRequest::Settings &settings) const;
+    template <typename Policy>
+    float move_cost(int cell, int direction) const;
+    template <typename Policy>
+    float estimate(const SearchState &state, int index, const PathRequest::Settings &settings) const;
+
+    float heuristic(const SearchState &state, int index, Heuristic type) const;
+    template <Heuristic H>
+    float heuristic(const SearchState &state, int index) const;
+    int direction_step(int from, int to) const;
+
+    // runs between a node and its parent are filled in with the cells along them unless the path is any-angle
+    void build_path(SearchState &state, bool anyAngle) const;
+    void emit_path(SearchState &state, PathRequest &request) const;
+    void rubberband(SearchState &state) const;
+    bool area_blocks_shortcut(int index0, int index1) const;
+    void smooth(SearchState &state, PathRequest &request) const;
+};
@@ -0,0 +1,334 @@
+#pragma once
+#include "P2_Pathfinding.h"
+#include "Misc/Stopwatch.h"
+
+/*
+    The A* search loop, built once per combination of settings.
+
+    A policy says which method and heuristic to use, whether to debug color or single step, and
+    whether moves take their cost from the terrain.  The specialized policies fix all five at
+    compile time, so every check on them folds away and the loop that is left has no per node
+    switches, and on maps without terrain costs no cost table is read at all.  The runtime policy
+    reads them from the settings for every node, it's what the search used to do and is kept to
+    measure against.  Both read the weighting mode from the settings, it's one well predicted
+    branch per node and not worth tripling the kernels for.
+
+    Each method's expansion lives in that method's file, which also builds its kernels with
+    specialized_kernel, so only this header needs to be shared.
+*/
+
+template <Method M, Heuristic H, bool DebugColoring, bool SingleStep, bool Weighted>
+struct SpecializedSearchPolicy
+{
+    static constexpr Method method = M;
+    static constexpr Heuristic heuristic = H;
+    static constexpr bool weighted = Weighted;
+
+    static constexpr bool debug_coloring(const PathRequest::Settings &)
+    {
+        return DebugColoring;
+    }
+
+    static constexpr bool single_step(const PathRequest::Settings &)
+    {
+        return SingleStep;
+    }
+};
+
+// NUM_ENTRIES marks a setting that is read at runtime, and the cost table is always read since it's right on every map
+struct RuntimeSearchPolicy
+{
+    static constexpr Method method = Method::NUM_ENTRIES;
+    static constexpr Heuristic heuristic = Heuristic::NUM_ENTRIES;
+    static constexpr bool weighted = true;
+
+    static bool debug_coloring(const PathRequest::Settings &settings)
+    {
+        return settings.debugColoring;
+    }
+
+    static bool single_step(const PathRequest::Settings &settings)
+    {
+        return settings.singleStep;
+    }
+};
+
+template <Method M>
+AStarPather::Kernel AStarPather::specialized_kernel(const PathRequest::Settings &settings, bool weighted)
+{
+    auto pick_cost = [weighted](auto heuristic, auto debugColoring, auto singleStep) -> Kernel
+    {
+        constexpr Heuristic H = decltype(heuristic)::value;
+        constexpr bool D = decltype(debugColoring)::value;
+        constexpr bool S = decltype(singleStep)::value;
+
+        // jump points skip over cells, which is only right when every cell costs the same
+        if constexpr (M == Method::JPS_PLUS)
+        {
+            return &AStarPather::search_kernel<SpecializedSearchPolicy<M, H, D, S, false>>;
+        }
+        else
+        {
+            return weighted == true ? &AStarPather::search_kernel<SpecializedSearchPolicy<M, H, D, S, true>> :
+                &AStarPather::search_kernel<SpecializedSearchPolicy<M, H, D, S, false>>;
+        }
+    };
+
+    auto pick = [&settings, &pick_cost](auto tag) -> Kernel
+    {
+        if (settings.debugColoring == true)
+        {
+            return settings.singleStep == true ? pick_cost(tag, std::true_type {}, std::true_type {}) :
+                pick_cost(tag, std::true_type {}, std::false_type {});
+        }
+
+        return settings.singleStep == true ? pick_cost(tag, std::false_type {}, std::true_type {}) :
+            pick_cost(tag, std::false_type {}, std::false_type {});
+    };
+
+    // Theta* always measures straight lines, none of the grid estimates are admissible for them
+    if constexpr (M == Method::THETA_STAR)
+    {
+        return pick(std::integral_constant<Heuristic, Heuristic::EUCLIDEAN> {});
+    }
+
+    switch (settings.heuristic)
+    {
+    case Heuristic::CHEBYSHEV:
+        return pick(std::integral_constant<Heuristic, Heuristic::CHEBYSHEV> {});
+    case Heuristic::INCONSISTENT:
+        return pick(std::integral_constant<Heuristic, Heuristic::INCONSISTENT> {});
+    case Heuristic::MANHATTAN:
+        return pick(std::integral_constant<Heuristic, Heuristic::MANHATTAN> {});
+    case Heuristic::EUCLIDEAN:
+        return pick(std::integral_constant<Heuristic, Heuristic::EUCLIDEAN> {});
+    case Heuristic::LANDMARK:
+        return pick(std::integral_constant<Heuristic, Heuristic::LANDMARK> {});
+    default:
+        return pick(std::integral_constant<Heuristic, Heuristic::OCTILE> {});
+    }
+}
+
+template <typename Policy>
+PathResult AStarPather::search_kernel(SearchState &state, const PathRequest::Settings &settings,
+    const std::chrono::high_resolution_clock::time_point *stopAt) const
+{
+    // reading the clock isn't free, so only check it every so often
+    constexpr unsigned deadlineCheckMask = 63;
+
+    unsigned expansions = 0;
+
+    const bool anyAngle = Policy::method == Method::THETA_STAR ||
+        (Policy::method == Method::NUM_ENTRIES && settings.method == Method::THETA_STAR);
+    const bool focal = settings.weighting == Weighting::FOCAL;
+
+    if (state.expanded == 0 && state.openList.empty() == false)
+    {
+        state.horizon = estimate<Policy>(state, state.openList.front(), settings);
+    }
+
+    while (state.openList.empty() == false)
+    {
+        const int current = focal == true ? state.pop_focal(settings.weight) : state.pop();
+
+        // lazy Theta* only checks the line to a node's parent once the node comes off the open list
+        if (anyAngle == true)
+        {
+            settle_any_angle<Policy>(state, current);
+        }
+
+        if (current == state.goalIndex)
+        {
+            build_path(state, anyAngle);
+            return PathResult::COMPLETE;
+        }
+
+        state.nodes[current].state = NodeState::CLOSED;
+        ++state.expanded;
+
+        if (Policy::debug_coloring(settings) == true)
+        {
+            terrain->set_color(current / width, current % width, Colors::Yellow);
+        }
+
+        if constexpr (Policy::method == Method::NUM_ENTRIES)
+        {
+            // on weighted maps jump point searches are plain A*, as select_kernel picks for them
+            switch (settings.method == Method::JPS_PLUS && uniformCost == false ? Method::ASTAR : settings.method)
+            {
+            case Method::JPS_PLUS:
+                expand_jump_points<Policy>(state, current, settings);
+                break;
+            case Method::GOAL_BOUNDING:
+                expand_bounded_neighbors<Policy>(state, current, settings);
+                break;
+            case Method::THETA_STAR:
+                expand_any_angle<Policy>(state, current, settings);
+                break;
+            default:
+                expand_neighbors<Policy>(state, current, settings);
+                break;
+            }
+        }
+        else if constexpr (Policy::method == Method::JPS_PLUS)
+        {
+            expand_jump_points<Policy>(state, current, settings);
+        }
+        else if constexpr (Policy::method == Method::GOAL_BOUNDING)
+        {
+            expand_bounded_neighbors<Policy>(state, current, settings);
+        }
+        else if constexpr (Policy::method == Method::THETA_STAR)
+        {
+            expand_any_angle<Policy>(state, current, settings);
+        }
+        else
+        {
+            expand_neighbors<Policy>(state, current, settings);
+        }
+
+        if (Policy::single_step(settings) == true)
+        {
+            return PathResult::PROCESSING;
+        }
+
+        if (stopAt != nullptr && (++expansions & deadlineCheckMask) == 0 && Stopwatch::now() >= *stopAt)
+        {
+            return PathResult::PROCESSING;
+        }
+    }
+
+    return PathResult::IMPOSSIBLE;
+}
+
+template <typename Policy>
+void AStarPather::relax(SearchState &state, int current, int next, float cost, const PathRequest::Settings &settings) const
+{
+    const float given = state.nodes[current].given + cost;
+
+    Node &neighbor = state.touch(next);
+
+    if (neighbor.state == NodeState::UNVISITED)
+    {
+        const float remaining = estimate<Policy>(state, next, settings);
+        float weight = settings.weight;
+
+        // focal search bounds the cost when picking, so it keeps the plain estimate for ordering
+        if (settings.weighting == Weighting::FOCAL)
+        {
+            weight = 1.0f;
+        }
+        else if (settings.weighting == Weighting::DYNAMIC && remaining < state.horizon)
+        {
+            weight = 1.0f + (settings.weight - 1.0f) * remaining / state.horizon;
+        }
+
+        neighbor.given = given;
+        neighbor.total = given + weight * remaining;
+        neighbor.parent = current;
+        state.push(next);
+
+        if (Policy::debug_coloring(settings) == true)
+        {
+            terrain->set_color(next / width, next % width, Colors::Blue);
+        }
+    }
+    else if (given < neighbor.given)
+    {
+        neighbor.total -= neighbor.given - given;
+        neighbor.given = given;
+        neighbor.parent = current;
+
+        if (neighbor.state == NodeState::OPEN)
+        {
+            state.update(next);
+        }
+        else
+        {
+            // an inconsistent heuristic can close a node too early, so reopen it
+            state.push(next);
+        }
+    }
+}
+
+template <typename Policy>
+float AStarPather::estimate(const SearchState &state, int index, const PathRequest::Settings &settings) const
+{
+    if constexpr (Policy::heuristic == Heuristic::NUM_ENTRIES)
+    {
+        // Theta* moves in straight lines, which only the euclidean estimate never overestimates
+        const Heuristic type = settings.method == Method::THETA_STAR ? Heuristic::EUCLIDEAN : settings.heuristic;
+        const float distance = heuristic(state, index, type);
+
+        // landmark distances already include the terrain costs, the others count moves over the cheapest ground
+        return type == Heuristic::LANDMARK ? distance : distance * costFloor;
+    }
+    else if constexpr (Policy::weighted == true && Policy::heuristic != Heuristic::LANDMARK)
+    {
+        return heuristic<Policy::heuristic>(state, index) * costFloor;
+    }
+    else
+    {
+        return heuristic<Policy::heuristic>(state, index);
+    }
+}
+
+template <typename Policy>
+float AStarPather::move_cost(int cell, int direction) const
+{
+    if constexpr (Policy::weighted == true)
+    {
+        return edgeCosts[cell * NUM_DIRECTIONS + direction];
+    }
+    else
+    {
+        return moveCost[direction];
+    }
+}
+
+template <Heuristic H>
+float AStarPather::heuristic(const SearchState &state, int index) const
+{
+    if constexpr (H == Heuristic::LANDMARK)
+    {
+        // by the triangle inequality each landmark bounds the distance by how much closer to it one end is
+        const float *node = &landmarkDistances[index * landmarkCount];
+        const float *goal = &landmarkDistances[state.goalIndex * landmarkCount];
+        float bound = 0.0f;
+
+        for (int i = 0; i < landmarkCount; ++i)
+        {
+            bound = std::max(bound, std::abs(goal[i] - node[i]));
+        }
+
+        return bound;
+    }
+    else
+    {
+        const int row = index / width;
+        const int col = index - row * width;
+        const float dRow = static_cast<float>(std::abs(row - state.goalPos.row));
+        const float dCol = static_cast<float>(std::abs(col - state.goalPos.col));
+
+        if constexpr (H == Heuristic::OCTILE)
+        {
+            return std::min(dRow, dCol) * (moveCost[NORTH_EAST] - 1.0f) + std::max(dRow, dCol);
+        }
+        else if constexpr (H == Heuristic::CHEBYSHEV)
+        {
+            return std::max(dRow, dCol);
+        }
+        else if constexpr (H == Heuristic::INCONSISTENT)
+        {
+            return ((row + col) % 2 > 0) ? std::sqrt(dRow * dRow + dCol * dCol) : 0.0f;
+        }
+        else if constexpr (H == Heuristic::MANHATTAN)
+        {
+            return dRow + dCol;
+        }
+        else
+        {
+            return std::sqrt(dRow * dRow + dCol * dCol);
+        }
+    }
+}
@@ -0,0 +1,155 @@
+#include <pch.h>
+#include "P2_Pathfinding.h"
+#include "P2_SearchKernel.h"
+#include "Terrain/MapMath.h"
+
+/*
+    Any-angle search, Theta* and Lazy Theta* (Nash, Daniel, Koenig and Felner).
+
+    A* on the grid, except a node may take its parent's parent as its own parent whenever the
+    straight line between them is clear, so parents end up at the corners the path turns around
+    and the path runs straight between them at any angle.  The finished path is already as taut
+    as it will get, so it isn't rubberbanded afterwards.
+
+    On maps without terrain costs this is the lazy variant: a node is assumed to see its
+    grandparent when it's generated, and the line is only checked once it comes off the open
+    list, which skips the checks for all the nodes that never do.  If the line turns out to be
+    blocked, the node falls back to the cheapest of its expanded neighbors, one of which
+    generated it.  With terrain costs a line costs its length times the most expensive cell it
+    crosses, which takes walking it anyway, so every line is checked as it's found.
+
+    Lines are walked through every cell they touch, and one passing exactly through a corner is
+    blocked by a wall on either side of it, the same as a diagonal move.
+*/
+
+AStarPather::Kernel AStarPather::any_angle_kernel(const PathRequest::Settings &settings) const
+{
+    return specialized_kernel<Method::THETA_STAR>(settings, uniformCost == false);
+}
+
+template <typename Policy>
+void AStarPather::expand_any_angle(SearchState &state, int current, const PathRequest::Settings &settings) const
+{
+    const unsigned char mask = neighbors[current];
+    const int grandparent = state.nodes[current].parent;
+
+    const bool lazy = (Policy::method == Method::NUM_ENTRIES) ? (uniformCost == true) : (Policy::weighted == false);
+
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        if ((mask & (1 << d)) == 0)
+        {
+            continue;
+        }
+
+        const int next = current + rowOffset[d] * width + colOffset[d];
+
+        if (state.nodes[next].generation == state.generation && state.nodes[next].state == NodeState::CLOSED)
+        {
+            continue;
+        }
+
+        if (grandparent == -1)
+        {
+            relax<Policy>(state, current, next, move_cost<Policy>(current, d), settings);
+        }
+        else if (lazy == true)
+        {
+            const int dRow = next / width - grandparent / width;
+            const int dCol = next % width - grandparent % width;
+
+            relax<Policy>(state, grandparent, next, std::sqrt(static_cast<float>(dRow * dRow + dCol * dCol)), settings);
+        }
+        else
+        {
+            // the line can cost more than going around it, so offer both and keep the cheaper
+            const float cost = line_cost<Policy>(grandparent, next);
+
+            if (cost != std::numeric_limits<float>::infinity())
+            {
+                relax<Policy>(state, grandparent, next, cost, settings);
+            }
+
+            relax<Policy>(state, current, next, move_cost<Policy>(current, d), settings);
+        }
+    }
+}
+
+template <typename Policy>
+void AStarPather::settle_any_angle(SearchState &state, int current) const
+{
+    Node &node = state.nodes[current];
+
+    // weighted searches check their lines when they find them
+    const bool lazy = (Policy::method == Method::NUM_ENTRIES) ? (uniformCost == true) : (Policy::weighted == false);
+
+    if (lazy == false || node.parent == -1 || line_cost<Policy>(node.parent, current) != std::numeric_limits<float>::infinity())
+    {
+        return;
+    }
+
+    const unsigned char mask = neighbors[current];
+    float best = std::numeric_limits<float>::infinity();
+    int parent = -1;
+
+    for (int d = 0; d < NUM_DIRECTIONS; ++d)
+    {
+        if ((mask & (1 << d)) == 0)
+        {
+            continue;
+        }
+
+        const int previous = current + rowOffset[d] * width + colOffset[d];
+        const Node &neighbor = state.nodes[previous];
+
+        if (neighbor.generation == state.generation && neighbor.state == NodeState::CLOSED &&
+            neighbor.given + move_cost<Policy>(current, d) < best)
+        {
+            best = neighbor.given + move_cost<Policy>(current, d);
+            parent = previous;
+        }
+    }
+
+    node.total += best - node.given;
+    node.given = best;
+    node.parent = parent;
+}
+
+template <typename Policy>
+float AStarPather::line_cost(int from, int to) const
+{
+    const auto &walls = grid->walls;
+    const auto &costs = grid->costs;
+
+    const int row0 = from / width;
+    const int col0 = from % width;
+    const int row1 = to / width;
+    const int col1 = to % width;
+
+    float highest = Policy::weighted == true ? costs[from] : 1.0f;
+
+    const auto wall = [&walls, this](int row, int col) { return walls[row * width + col] != 0; };
+    const auto enter = [&costs, &highest, this](int row, int col)
+    {
+        if constexpr (Policy::weighted == true)
+        {
+            highest = std::max(highest, costs[row * width + col]);
+        }
+    };
+
+    // center to center, in half cells
+    if (trace_grid_line(row0 * 2 + 1, col0 * 2 + 1, row1 * 2 + 1, col1 * 2 + 1, wall, enter) == false)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    const int rows = row1 - row0;
+    const int cols = col1 - col0;
+
+    return std::sqrt(static_cast<float>(rows * rows + cols * cols)) * highest;
+}
+
+// the runtime kernel in P2_Pathfinding.cpp expands through these
+template void AStarPather::expand_any_angle<RuntimeSearchPolicy>(SearchState &state, int current,
+    const PathRequest::Settings &settings) const;
+template void AStarPather::settle_any_angle<RuntimeSearchPolicy>(SearchState &state, int current) const;
@@ -0,0 +1,106 @@
+#include <pch.h>
+#include "P2_WorkerPool.h"
+
+WorkerPool::WorkerPool() : current(nullptr), taskCount(0), nextTask(0), batch(0), busy(0), stopping(false)
+{}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start(unsigned numWorkers)
+{
+    stop();
+
+    stopping = false;
+    threads.reserve(numWorkers > 1 ? numWorkers - 1 : 0);
+
+    for (unsigned worker = 1; worker < numWorkers; ++worker)
+    {
+        threads.emplace_back(&WorkerPool::worker_loop, this, worker, batch);
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wake.notify_all();
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    threads.clear();
+}
+
+void WorkerPool::run(size_t count, const Task &task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &task;
+        taskCount = count;
+        nextTask = 0;
+        busy = static_cast<unsigned>(threads.size());
+        ++batch;
+    }
+
+    wake.notify_all();
+
+    work(0);
+
+    // every thread checks in once per batch, so nothing can still be touching task after this
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return busy == 0; });
+    current = nullptr;
+}
+
+unsigned WorkerPool::size() const
+{
+    return static_cast<unsigned>(threads.size()) + 1;
+}
+
+void WorkerPool::worker_loop(unsigned worker, unsigned seen)
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen]() { return stopping == true || batch != seen; });
+
+            if (stopping == true)
+            {
+                return;
+            }
+
+            seen = batch;
+        }
+
+        work(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (--busy == 0)
+        {
+            finished.notify_one();
+        }
+    }
+}
+
+void WorkerPool::work(unsigned worker)
+{
+    for (size_t task = nextTask++; task < taskCount; task = nextTask++)
+    {
+        (*current)(worker, task);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
+
+// a fixed set of threads that work through batches of independent tasks,
+// the thread calling run joins in as worker 0 rather than sitting idle
+class WorkerPool
+{
+public:
+    using Task = std::function<void(unsigned worker, size_t task)>;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    // numWorkers counts the calling thread, so one starts no threads at all
+    void start(unsigned numWorkers);
+    void stop();
+
+    // blocks until task has been called once for every index in [0, count)
+    void run(size_t count, const Task &task);
+
+    unsigned size() const;
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const Task *current;
+    size_t taskCount;
+    std::atomic<size_t> nextTask;
+
+    // bumped for every run, so a waking thread can tell a new batch from a spurious wake up
+    unsigned batch;
+    unsigned busy;
+    bool stopping;
+
+    void worker_loop(unsigned worker, unsigned seen);
+    void work(unsigned worker);
+};
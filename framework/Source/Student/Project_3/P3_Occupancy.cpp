@@ -0,0 +1,295 @@
+#include <pch.h>
+#include <intrin.h>
+#include <immintrin.h>
+#include "P3_Occupancy.h"
+#include "Terrain/MapMath.h"
+
+/*
+    Occupancy propagation, eight lanes at a time.
+
+    Each open cell takes the largest of its neighbors' values, decayed by how far away they are,
+    and moves part of the way toward it.  The rows are padded so the cells at the edges read
+    zeros like any other neighbor, and whether each neighbor counts comes from a bitmask worked
+    out once per map instead of from the walls: a wall never passes influence, and neither does
+    a diagonal neighbor past the corner of one.  A neighbor that doesn't count is read anyway
+    and zeroed by its bit, which picks the same value the scalar loop gets by skipping it, so
+    all three kernels give exactly the same grid.
+
+    The AVX2 kernel is used when the processor has it, SSE2 otherwise, and the scalar kernel is
+    the reference the other two are measured against.
+*/
+
+namespace
+{
+    // in the order the masks number them, the diagonals are the corners of the three by three block
+    const int neighborRow[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+    const int neighborCol[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+
+    bool is_diagonal(int direction)
+    {
+        return neighborRow[direction] != 0 && neighborCol[direction] != 0;
+    }
+}
+
+OccupancyGrid::OccupancyGrid() : height(0), width(0), stride(0), offsets {}
+{}
+
+void OccupancyGrid::build(int mapHeight, int mapWidth, const std::function<bool(int, int)> &isWall)
+{
+    height = mapHeight;
+    width = mapWidth;
+
+    // room for a register read starting at the last cell and one more neighbor beyond it
+    stride = (width + 9 + 7) / 8 * 8;
+
+    const size_t size = static_cast<size_t>((height + 2) * stride);
+    front.assign(size, 0.0f);
+    back.assign(size, 0.0f);
+    masks.assign(size, 0);
+
+    for (int d = 0; d < 8; ++d)
+    {
+        offsets[d] = neighborRow[d] * stride + neighborCol[d];
+    }
+
+    const auto open = [&](int row, int col)
+    {
+        return row >= 0 && row < height && col >= 0 && col < width && isWall(row, col) == false;
+    };
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            if (open(row, col) == false)
+            {
+                continue;
+            }
+
+            uint16_t mask = openBit;
+
+            for (int d = 0; d < 8; ++d)
+            {
+                const int r = row + neighborRow[d];
+                const int c = col + neighborCol[d];
+
+                if (open(r, c) == true && (is_diagonal(d) == false || (open(r, col) == true && open(row, c) == true)))
+                {
+                    mask |= 1 << d;
+                }
+            }
+
+            masks[(row + 1) * stride + col + 1] = mask;
+        }
+    }
+}
+
+int OccupancyGrid::get_height() const
+{
+    return height;
+}
+
+int OccupancyGrid::get_width() const
+{
+    return width;
+}
+
+float *OccupancyGrid::get_row(int row)
+{
+    return &front[(row + 1) * stride + 1];
+}
+
+const float *OccupancyGrid::get_row(int row) const
+{
+    return &front[(row + 1) * stride + 1];
+}
+
+void OccupancyGrid::propagate(float decay, float growth, bool dual, OccupancyKernel kernel)
+{
+    const float cardinal = std::exp(-decay);
+    const float diagonal = std::exp(-std::sqrt(2.0f) * decay);
+
+    if (kernel == OccupancyKernel::BEST)
+    {
+        kernel = has_avx2() == true ? OccupancyKernel::AVX2 : OccupancyKernel::SSE2;
+    }
+
+    // values left to fade for long enough go denormal, which is many times slower on every kernel, so flush them
+    const unsigned int control = _mm_getcsr();
+    _mm_setcsr(control | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+
+    switch (kernel)
+    {
+    case OccupancyKernel::AVX2:
+        propagate_avx2(cardinal, diagonal, growth, dual);
+        break;
+    case OccupancyKernel::SSE2:
+        propagate_sse2(cardinal, diagonal, growth, dual);
+        break;
+    default:
+        propagate_scalar(cardinal, diagonal, growth, dual);
+        break;
+    }
+
+    _mm_setcsr(control);
+    front.swap(back);
+}
+
+bool OccupancyGrid::has_avx2()
+{
+    // the processor has to support it, and the operating system has to save the wider registers
+    static const bool supported = []()
+    {
+        int info[4];
+        __cpuid(info, 0);
+
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        __cpuid(info, 1);
+
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        if (osxsave == false || avx == false || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+
+        return (info[1] & (1 << 5)) != 0;
+    }();
+
+    return supported;
+}
+
+void OccupancyGrid::propagate_scalar(float cardinal, float diagonal, float growth, bool dual)
+{
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            const int cell = (row + 1) * stride + col + 1;
+            const uint16_t mask = masks[cell];
+
+            if ((mask & openBit) == 0)
+            {
+                back[cell] = front[cell];
+                continue;
+            }
+
+            float highest = 0.0f;
+
+            for (int d = 0; d < 8; ++d)
+            {
+                if ((mask & (1 << d)) == 0)
+                {
+                    continue;
+                }
+
+                const float value = front[cell + offsets[d]] * (is_diagonal(d) == true ? diagonal : cardinal);
+
+                if (dual == true ? std::abs(value) > std::abs(highest) : value > highest)
+                {
+                    highest = value;
+                }
+            }
+
+            back[cell] = lerp(front[cell], highest, growth);
+        }
+    }
+}
+
+void OccupancyGrid::propagate_sse2(float cardinal, float diagonal, float growth, bool dual)
+{
+    const __m128 factors[2] = { _mm_set1_ps(cardinal), _mm_set1_ps(diagonal) };
+    const __m128 t = _mm_set1_ps(growth);
+    const __m128 oneMinusT = _mm_set1_ps(1.0f - growth);
+    const __m128 magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128i open = _mm_set1_epi32(openBit);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int row = 0; row < height; ++row)
+    {
+        const int first = (row + 1) * stride + 1;
+
+        for (int col = 0; col < width; col += 4)
+        {
+            const int cell = first + col;
+
+            const __m128i bits = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&masks[cell])), zero);
+            const __m128 current = _mm_loadu_ps(&front[cell]);
+            __m128 highest = _mm_setzero_ps();
+
+            for (int d = 0; d < 8; ++d)
+            {
+                const __m128i bit = _mm_set1_epi32(1 << d);
+                const __m128 counts = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(bits, bit), bit));
+                const __m128 value = _mm_and_ps(_mm_mul_ps(_mm_loadu_ps(&front[cell + offsets[d]]), factors[is_diagonal(d)]), counts);
+
+                if (dual == true)
+                {
+                    const __m128 further = _mm_cmpgt_ps(_mm_and_ps(value, magnitude), _mm_and_ps(highest, magnitude));
+                    highest = _mm_or_ps(_mm_and_ps(further, value), _mm_andnot_ps(further, highest));
+                }
+                else
+                {
+                    highest = _mm_max_ps(highest, value);
+                }
+            }
+
+            const __m128 moved = _mm_add_ps(_mm_mul_ps(oneMinusT, current), _mm_mul_ps(t, highest));
+            const __m128 updated = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(bits, open), open));
+
+            _mm_storeu_ps(&back[cell], _mm_or_ps(_mm_and_ps(updated, moved), _mm_andnot_ps(updated, current)));
+        }
+    }
+}
+
+void OccupancyGrid::propagate_avx2(float cardinal, float diagonal, float growth, bool dual)
+{
+    const __m256 factors[2] = { _mm256_set1_ps(cardinal), _mm256_set1_ps(diagonal) };
+    const __m256 t = _mm256_set1_ps(growth);
+    const __m256 oneMinusT = _mm256_set1_ps(1.0f - growth);
+    const __m256 magnitude = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256i open = _mm256_set1_epi32(openBit);
+
+    for (int row = 0; row < height; ++row)
+    {
+        const int first = (row + 1) * stride + 1;
+
+        for (int col = 0; col < width; col += 8)
+        {
+            const int cell = first + col;
+
+            const __m256i bits = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&masks[cell])));
+            const __m256 current = _mm256_loadu_ps(&front[cell]);
+            __m256 highest = _mm256_setzero_ps();
+
+            for (int d = 0; d < 8; ++d)
+            {
+                const __m256i bit = _mm256_set1_epi32(1 << d);
+                const __m256 counts = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(bits, bit), bit));
+                const __m256 value = _mm256_and_ps(_mm256_mul_ps(_mm256_loadu_ps(&front[cell + offsets[d]]), factors[is_diagonal(d)]), counts);
+
+                if (dual == true)
+                {
+                    const __m256 further = _mm256_cmp_ps(_mm256_and_ps(value, magnitude), _mm256_and_ps(highest, magnitude), _CMP_GT_OQ);
+                    highest = _mm256_blendv_ps(highest, value, further);
+                }
+                else
+                {
+                    highest = _mm256_max_ps(highest, value);
+                }
+            }
+
+            const __m256 moved = _mm256_add_ps(_mm256_mul_ps(oneMinusT, current), _mm256_mul_ps(t, highest));
+            const __m256 updated = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(bits, open), open));
+
+            _mm256_storeu_ps(&back[cell], _mm256_blendv_ps(current, moved, updated));
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+// which kernel propagates the occupancy, the best one the processor has unless the caller asks for another
+enum class OccupancyKernel
+{
+    SCALAR,
+    SSE2,
+    AVX2,
+    BEST
+};
+
+// a copy of an occupancy layer laid out for the propagation kernels, each row padded with empty cells on both
+// sides and out to a whole number of AVX registers, with empty rows above and below, so every neighbor read
+// of every cell the kernels touch is in bounds
+class OccupancyGrid
+{
+public:
+    OccupancyGrid();
+
+    // lays the grid out for a map and works out which neighbors each cell takes influence from
+    void build(int height, int width, const std::function<bool(int, int)> &isWall);
+
+    int get_height() const;
+    int get_width() const;
+
+    // the first cell of a row of the current values, the rest of the row follows it
+    float *get_row(int row);
+    const float *get_row(int row) const;
+
+    // one step of the stencil, every open cell moving toward the highest decayed value among the neighbors it
+    // can see, or the furthest from zero when dual, written to the other buffer which then becomes the current one
+    void propagate(float decay, float growth, bool dual, OccupancyKernel kernel = OccupancyKernel::BEST);
+
+    static bool has_avx2();
+
+private:
+    int height;
+    int width;
+
+    // floats from one row to the next, the first cell of a row sits one past the start of it
+    int stride;
+
+    std::vector<float> front;
+    std::vector<float> back;
+
+    // bit d is set when neighbor d passes influence, a cell past a wall corner doesn't, and the open bit when the
+    // cell itself is updated at all, padding and walls keep whatever they hold
+    std::vector<uint16_t> masks;
+    static const uint16_t openBit = 1 << 8;
+
+    int offsets[8];
+
+    void propagate_scalar(float cardinal, float diagonal, float growth, bool dual);
+    void propagate_sse2(float cardinal, float diagonal, float growth, bool dual);
+    void propagate_avx2(float cardinal, float diagonal, float growth, bool dual);
+};
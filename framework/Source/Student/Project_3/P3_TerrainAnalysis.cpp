@@ -4,6 +4,7 @@
 #include "Agent/AStarAgent.h"
 #include "Terrain/MapLayer.h"
 #include "Projects/ProjectThree.h"
+#include "P3_Occupancy.h"
 
 #include <iostream>
 
@@ -12,57 +13,94 @@ bool ProjectThree::implemented_fog_of_war() const // extra credit
     return false;
 }
 
+namespace
+{
+    // laid out again only when the walls or the map change, which is what replaces the snapshot
+    OccupancyGrid &occupancy_grid()
+    {
+        static OccupancyGrid grid;
+        static std::shared_ptr<const GridSnapshot> builtFor;
+
+        const auto snapshot = terrain->get_snapshot();
+
+        if (snapshot != builtFor)
+        {
+            grid.build(terrain->get_map_height(), terrain->get_map_width(),
+                [](int row, int col) { return terrain->is_wall(row, col); });
+            builtFor = snapshot;
+        }
+
+        return grid;
+    }
+
+    void propagate_occupancy(MapLayer<float> &layer, float decay, float growth, bool dual)
+    {
+        OccupancyGrid &grid = occupancy_grid();
+
+        for (int row = 0; row < grid.get_height(); ++row)
+        {
+            float *values = grid.get_row(row);
+
+            for (int col = 0; col < grid.get_width(); ++col)
+            {
+                values[col] = layer.get_value(row, col);
+            }
+        }
+
+        grid.propagate(decay, growth, dual);
+
+        for (int row = 0; row < grid.get_height(); ++row)
+        {
+            const float *values = grid.get_row(row);
+
+            for (int col = 0; col < grid.get_width(); ++col)
+            {
+                layer.set_value(row, col, values[col]);
+            }
+        }
+    }
+}
+
 float distance_to_closest_wall(int row, int col)
 {
     /*
-        Check the euclidean distance from the given cell to every other wall cell,
-        with cells outside the map bounds treated as walls, and return the smallest
-        distance.  Make use of the is_valid_grid_position and is_wall member
-        functions in the global terrain to determine if a cell is within map bounds
-        and a wall, respectively.
+        The euclidean distance from the given cell to the closest wall cell, with cells
+        outside the map bounds treated as walls.  The terrain keeps an exact distance
+        transform of the walls, rebuilt whenever they change, so this is a lookup rather
+        than a scan over every wall.
     */
 
-    // WRITE YOUR CODE HERE
-    
-    return 0.0f; // REPLACE THIS
+    return terrain->get_wall_distance(row, col);
 }
 
 bool is_clear_path(int row0, int col0, int row1, int col1)
 {
-    // Check walls only within bounding box
-    float minrow = (row0 > row1) ? static_cast<float>(row1) : static_cast<float>(row0);
-    float maxrow = (row0 > row1) ? static_cast<float>(row0) : static_cast<float>(row1);
-    float mincol = (col0 > col1) ? static_cast<float>(col1) : static_cast<float>(col0);
-    float maxcol = (col0 > col1) ? static_cast<float>(col0) : static_cast<float>(col1);
+    /*
+        The line runs between the two cell centers, see trace_grid_line for what blocks it.
+        A cell can always see itself.
+    */
+
+    if (row0 == row1 && col0 == col1)
+    {
+        return true;
+    }
 
-    Vec2 startline = Vec2(static_cast<float>(row0) / 20.0f, static_cast<float>(col0) / 20.0f);
-    Vec2 endline = Vec2(static_cast<float>(row1) / 20.0f, static_cast<float>(col1) / 20.0f);
+    return trace_grid_line(row0 * 2 + 1, col0 * 2 + 1, row1 * 2 + 1, col1 * 2 + 1,
+        [](int row, int col) { return terrain->is_wall(row, col); });
+}
 
-    float offset = 1.0f / 40.0f + FLT_EPSILON;
+void trace_clear_paths(const unsigned char *walls, int width, int row, int col, const GridPos *targets, int count, unsigned char *clear)
+{
+    // every line reads the caller's flat wall grid instead of going through the terrain's layer
+    const auto wall = [walls, width](int r, int c) { return walls[r * width + c] != 0; };
 
-    for (float i = minrow; i <= maxrow; ++i)
+    for (int i = 0; i < count; ++i)
     {
-        for (float j = mincol; j <= maxcol; ++j)
-        {
-            if (terrain->is_wall(static_cast<int>(i), static_cast<int>(j)))
-            {
-                // Check if line intersects any of 4 edges
-                Vec2 tl = Vec2(static_cast<float>(i / 20.0f - offset), static_cast<float>(j / 20.0f - offset));
-                Vec2 tr = Vec2(static_cast<float>(i / 20.0f + offset), static_cast<float>(j / 20.0f - offset));
-                Vec2 bl = Vec2(static_cast<float>(i / 20.0f - offset), static_cast<float>(j / 20.0f + offset));
-                Vec2 br = Vec2(static_cast<float>(i / 20.0f + offset), static_cast<float>(j / 20.0f + offset));
-
-                if (line_intersect(startline, endline, tl, tr) ||
-                    line_intersect(startline, endline, tl, bl) ||
-                    line_intersect(startline, endline, bl, br) ||
-                    line_intersect(startline, endline, tr, br))
-                        return true;
-                
-            }
-        }
-    }
+        const GridPos &target = targets[i];
 
-    return false;
+        clear[i] = ((target.row == row && target.col == col) ||
+            trace_grid_line(row * 2 + 1, col * 2 + 1, target.row * 2 + 1, target.col * 2 + 1, wall)) ? 1 : 0;
+    }
 }
 
 bool is_clear_path(Vec3 const& s1, Vec3 const& e1, Vec3 s2, Vec3 e2)
@@ -107,7 +145,23 @@ void analyze_openness(MapLayer<float> &layer)
         distance_to_closest_wall helper function.  Walls should not be marked.
     */
 
-    // WRITE YOUR CODE HERE
+    const int height = terrain->get_map_height();
+    const int width = terrain->get_map_width();
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            if (terrain->is_wall(row, col) == true)
+            {
+                layer.set_value(row, col, 0.0f);
+                continue;
+            }
+
+            const float distance = distance_to_closest_wall(row, col);
+            layer.set_value(row, col, 1.0f / (distance * distance));
+        }
+    }
 }
 
 void analyze_visibility(MapLayer<float> &layer)
@@ -122,7 +176,21 @@ void analyze_visibility(MapLayer<float> &layer)
         helper function.
     */
 
-    // WRITE YOUR CODE HERE
+    // the terrain tested every pair with is_clear_path when the walls last changed and kept the answers,
+    // so this is a count of the cell's bits
+    const int height = terrain->get_map_height();
+    const int width = terrain->get_map_width();
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            if (terrain->is_wall(row, col) == false)
+            {
+                layer.set_value(row, col, std::min(terrain->count_visible(row, col) / 160.0f, 1.0f));
+            }
+        }
+    }
 }
 
 void analyze_visible_to_cell(MapLayer<float> &layer, int row, int col)
@@ -137,7 +205,38 @@ void analyze_visible_to_cell(MapLayer<float> &layer, int row, int col)
         helper function.
     */
 
-    // WRITE YOUR CODE HERE
+    const int height = terrain->get_map_height();
+    const int width = terrain->get_map_width();
+
+    for (int r = 0; r < height; ++r)
+    {
+        for (int c = 0; c < width; ++c)
+        {
+            layer.set_value(r, c, terrain->is_visible(row, col, r, c) == true ? 1.0f : 0.0f);
+        }
+    }
+
+    for (int r = 0; r < height; ++r)
+    {
+        for (int c = 0; c < width; ++c)
+        {
+            if (terrain->is_wall(r, c) == true || terrain->is_visible(row, col, r, c) == true)
+            {
+                continue;
+            }
+
+            for (int dr = -1; dr <= 1; ++dr)
+            {
+                for (int dc = -1; dc <= 1; ++dc)
+                {
+                    if (terrain->is_valid_grid_position(r + dr, c + dc) == true && terrain->is_visible(row, col, r + dr, c + dc) == true)
+                    {
+                        layer.set_value(r, c, 0.5f);
+                    }
+                }
+            }
+        }
+    }
 }
 
 void analyze_agent_vision(MapLayer<float> &layer, const Agent *agent)
@@ -160,7 +259,45 @@ void analyze_agent_vision(MapLayer<float> &layer, const Agent *agent)
         helper function.
     */
 
-    // WRITE YOUR CODE HERE
+    // a little past straight out to the sides
+    const float fieldOfView = 185.0f;
+    const float minCosine = std::cos(DirectX::XMConvertToRadians(fieldOfView * 0.5f));
+
+    const Vec3 &position = agent->get_position();
+    const GridPos cell = terrain->get_grid_position(position);
+
+    if (terrain->is_valid_grid_position(cell) == false || terrain->is_wall(cell) == true)
+    {
+        return;
+    }
+
+    const Vec3 forward = agent->get_forward_vector();
+    Vec2 view(forward.x, forward.z);
+    view.Normalize();
+
+    const int height = terrain->get_map_height();
+    const int width = terrain->get_map_width();
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            if (terrain->is_visible(cell.row, cell.col, row, col) == false)
+            {
+                continue;
+            }
+
+            const Vec3 &target = terrain->get_world_position(row, col);
+            Vec2 toCell(target.x - position.x, target.z - position.z);
+            toCell.Normalize();
+
+            // the agent's own cell is always in view
+            if ((row == cell.row && col == cell.col) || view.Dot(toCell) >= minCosine)
+            {
+                layer.set_value(row, col, 1.0f);
+            }
+        }
+    }
 }
 
 void propagate_solo_occupancy(MapLayer<float> &layer, float decay, float growth)
@@ -179,7 +316,8 @@ void propagate_solo_occupancy(MapLayer<float> &layer, float decay, float growth)
         the given layer;
     */
     
-    // WRITE YOUR CODE HERE
+    // the grid keeps both buffers and the wall masks, so this works on a copy of the layer
+    propagate_occupancy(layer, decay, growth, false);
 }
 
 void propagate_dual_occupancy(MapLayer<float> &layer, float decay, float growth)
@@ -200,7 +338,8 @@ void propagate_dual_occupancy(MapLayer<float> &layer, float decay, float growth)
         the given layer;
     */
 
-    // WRITE YOUR CODE HERE
+    // the same stencil, keeping whichever neighbor is furthest from zero
+    propagate_occupancy(layer, decay, growth, true);
 }
 
 void normalize_solo_occupancy(MapLayer<float> &layer)
@@ -245,7 +384,48 @@ void enemy_field_of_view(MapLayer<float> &layer, float fovAngle, float closeDist
         as a fov cone.
     */
 
-    // WRITE YOUR CODE HERE
+    layer.for_each([](float &value) { value = std::max(value, 0.0f); });
+
+    const Vec3 &position = enemy->get_position();
+    const GridPos cell = terrain->get_grid_position(position);
+
+    if (terrain->is_valid_grid_position(cell) == false || terrain->is_wall(cell) == true)
+    {
+        return;
+    }
+
+    const float minCosine = std::cos(DirectX::XMConvertToRadians(fovAngle * 0.5f));
+
+    const Vec3 forward = enemy->get_forward_vector();
+    Vec2 view(forward.x, forward.z);
+    view.Normalize();
+
+    const int height = terrain->get_map_height();
+    const int width = terrain->get_map_width();
+
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            if (terrain->is_visible(cell.row, cell.col, row, col) == false)
+            {
+                continue;
+            }
+
+            // measured in cells, like the detection radius slider
+            const float dRow = static_cast<float>(row - cell.row);
+            const float dCol = static_cast<float>(col - cell.col);
+
+            const Vec3 &target = terrain->get_world_position(row, col);
+            Vec2 toCell(target.x - position.x, target.z - position.z);
+            toCell.Normalize();
+
+            if (std::sqrt(dRow * dRow + dCol * dCol) < closeDistance || view.Dot(toCell) >= minCosine)
+            {
+                layer.set_value(row, col, occupancyValue);
+            }
+        }
+    }
 }
 
 bool enemy_find_player(MapLayer<float> &layer, AStarAgent *enemy, Agent *player)